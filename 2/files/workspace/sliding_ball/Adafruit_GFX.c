@@ -128,8 +128,100 @@ void drawCircleHelper( int x0, int y0,
   }
 }
 
+// Half-heights of the columns of a filled circle for dx = 0..r, the same
+// pixels the Bresenham loop in fillCircleHelper() covers. Radii up to
+// CIRCLE_TABLE_RADIUS are precomputed; radius r starts at r*(r+1)/2.
+#define CIRCLE_TABLE_RADIUS  10
+static const unsigned char circleSpanTable[] = {
+  0,
+  1, 0,
+  2, 2, 1,
+  3, 3, 2, 1,
+  4, 4, 3, 3, 1,
+  5, 5, 5, 4, 3, 2,
+  6, 6, 6, 5, 4, 3, 2,
+  7, 7, 7, 6, 6, 5, 4, 2,
+  8, 8, 8, 7, 7, 6, 5, 4, 2,
+  9, 9, 9, 8, 8, 7, 7, 6, 4, 2,
+  10, 10, 10, 10, 9, 9, 8, 7, 6, 5, 3
+};
+
+// Column half-heights for radius r, from the table or worked out into buf
+// (r+1 entries). The fill is symmetric, so these are also the row
+// half-widths.
+const unsigned char *circleSpans(int r, unsigned char *buf) {
+  int f     = 1 - r;
+  int ddF_x = 1;
+  int ddF_y = -2 * r;
+  int x     = 0;
+  int y     = r;
+  int i;
+
+  if (r <= CIRCLE_TABLE_RADIUS) return &circleSpanTable[r*(r+1)/2];
+
+  buf[0] = r;
+  for (i = 1; i <= r; i++) buf[i] = 0;
+
+  while (x<y) {
+    if (f >= 0) {
+      y--;
+      ddF_y += 2;
+      f     += ddF_y;
+    }
+    x++;
+    ddF_x += 2;
+    f     += ddF_x;
+
+    if (buf[x] < y) buf[x] = y;
+    if (buf[y] < x) buf[y] = x;
+  }
+  return buf;
+}
+
+// fillRect() clipped to the screen
+static void fillSpan(int x, int y, int w, int h, unsigned int color) {
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (x + w > WIDTH) w = WIDTH - x;
+  if (y + h > HEIGHT) h = HEIGHT - y;
+  if (w <= 0 || h <= 0) return;
+
+  fillRect(x, y, w, h, color);
+}
+
+// Fill the circle columns dx = first..r on the sides picked by cornername.
+// Neighbouring columns of the same height go out as one rectangle, and the
+// center run joins both sides, so each distinct height costs one window
+// per side.
+static void fillCircleSpans(int x0, int y0, int r, unsigned char cornername,
+                            int delta, int first, unsigned int color) {
+  unsigned char buf[WIDTH];
+  const unsigned char *spans = circleSpans(r, buf);
+  int a, b, h;
+
+  for (a = first; a <= r; a = b + 1) {
+    h = spans[a];
+    for (b = a; b < r && spans[b+1] == h; b++) ;
+
+    if (a == 0 && cornername == 3) {
+      fillSpan(x0-b, y0-h, 2*b+1, 2*h+1+delta, color);
+      continue;
+    }
+    if (cornername & 0x1) {
+      fillSpan(x0+a, y0-h, b-a+1, 2*h+1+delta, color);
+    }
+    if (cornername & 0x2) {
+      fillSpan(x0-b, y0-h, b-a+1, 2*h+1+delta, color);
+    }
+  }
+}
+
 void fillCircle(int x0, int y0, int r,
 			      unsigned int color) {
+  if (r >= 0 && r < WIDTH) {
+    fillCircleSpans(x0, y0, r, 3, 0, 0, color);
+    return;
+  }
   drawFastVLine(x0, y0-r, 2*r+1, color);
   fillCircleHelper(x0, y0, r, 3, 0, color);
 }
@@ -144,6 +236,12 @@ void fillCircleHelper(int x0, int y0, int r,
   int x     = 0;
   int y     = r;
 
+  // the loop below only reaches the center column when r == 1
+  if (r >= 0 && r < WIDTH) {
+    fillCircleSpans(x0, y0, r, cornername, delta, r == 1 ? 0 : 1, color);
+    return;
+  }
+
   while (x<y) {
     if (f >= 0) {
       y--;
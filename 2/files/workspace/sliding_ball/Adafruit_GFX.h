@@ -42,6 +42,7 @@
     void drawCircleHelper(int x0, int y0, int r, unsigned char cornername, unsigned int color);
     void fillCircle(int x0, int y0, int r, unsigned int color);
     void fillCircleHelper(int x0, int y0, int r, unsigned char cornername, int delta, unsigned int color);
+    const unsigned char *circleSpans(int r, unsigned char *buf);
     void drawTriangle(int x0, int y0, int x1, int y1, int x2, int y2, unsigned int color);
     void fillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, unsigned int color);
     void drawRoundRect(int x0, int y0, int w, int h, int radius, unsigned int color);
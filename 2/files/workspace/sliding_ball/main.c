@@ -76,6 +76,7 @@
 #include "Adafruit_SSD1351.h"
 #include "Adafruit_GFX.h"
 #include "oled_test.h"
+#include "oled_sprite.h"
 #include "gpio.h"
 #include "i2c_if.h"
 #include <stdio.h>
@@ -140,18 +141,24 @@ static void delay(unsigned long ulCount){
 #define ACCELERATION_CHANGE   3
 #define BUMP_DAMP_MULTIPLIER   1
 
+// Uncomment to print how many pixels and bytes the ball redraws cost over
+// the UART every STATS_FRAMES frames, next to a full erase and redraw
+// #define BALL_STATS
+#define STATS_FRAMES   64
+
 
 static int ball_x, ball_y, ball_ax, ball_ay;
-static int old_x, old_y, old_ax, old_ay;
+static int old_ax, old_ay;
 
 static int accel_x, accel_y;
 static int old_accel_x, old_accel_y;
 
 unsigned short currentRadius = INIT_BALL_RADIUS;
-unsigned short oldRadius = INIT_BALL_RADIUS;
 unsigned short growRate = 2;
 unsigned short ballState = ON_FLOOR;
 
+static Sprite ball;
+
 // helper function
 static int clamp_int(int v, int lo, int hi){
     if (v < lo) return lo;
@@ -184,11 +191,27 @@ static void clampBall(int radius){
 }
 
 
-static void eraseBall(int x, int y, int radius){
-    fillCircle(x, y, radius, BLACK);
-}
+// Only the pixels that change between the old and new ball are sent
 static void drawBall(int x, int y, int radius){
-    fillCircle(x, y, radius, BALL_COLOR);
+    spriteMove(&ball, x, y, radius);
+
+#ifdef BALL_STATS
+    static unsigned long frames, pixels, bytes, fullPixels, fullBytes;
+
+    if (spritePixels == 0) return;
+    frames++;
+    pixels += spritePixels;
+    bytes += spriteBytes;
+    fullPixels += spriteFullPixels;
+    fullBytes += spriteFullBytes;
+
+    if (frames == STATS_FRAMES) {
+        Report("ball: %lu px %lu bytes per frame, full redraw %lu px %lu bytes\n\r",
+               pixels / frames, bytes / frames,
+               fullPixels / frames, fullBytes / frames);
+        frames = pixels = bytes = fullPixels = fullBytes = 0;
+    }
+#endif
 }
 
 // Reading accelerometer data
@@ -250,11 +273,9 @@ void ballPitch(void){
 }
 
 void increaseRadius(void){
-    oldRadius = currentRadius;
     currentRadius += growRate;
 }
 void decreaseRadius(void){
-    oldRadius = currentRadius;
     currentRadius -= growRate;
 }
 
@@ -292,29 +313,20 @@ void initScreen(void){
     ball_x = OLED_WIDTH / 2;
     ball_y = OLED_HEIGHT / 2;
 
-    old_x = ball_x;
-    old_y = ball_y;
-
     // Draw initial ball
     fillScreen(BLACK);
+    spriteInit(&ball, BALL_COLOR, BLACK);
     drawBall(ball_x, ball_y, currentRadius);
 }
 
 void updateBallPosition(void){
-    // Save old position
-    old_x = ball_x;
-    old_y = ball_y;
-
     // Update position from accelerometer
     ballRoll();
     ballPitch();
     clampBall(currentRadius);
 
-    // Only redraw if position changed
-    if (ball_x != old_x || ball_y != old_y){
-        eraseBall(old_x, old_y, oldRadius);
-        drawBall(ball_x, ball_y, currentRadius);
-    }
+    // Redraw if the position or size changed
+    drawBall(ball_x, ball_y, currentRadius);
 
     // Max speed
 //    delay(5);
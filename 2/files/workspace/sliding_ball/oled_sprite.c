@@ -0,0 +1,176 @@
+/* Delta sprite redraw.
+*
+*  A circle of radius r covers, on row y0+dy, the columns within
+*  circleSpans(r)[|dy|] of x0. Moving it from one place or size to another
+*  only changes the rows where the old and new spans differ: the part of
+*  the old span outside the new one is painted in the background color and
+*  the part of the new span outside the old one in the sprite color. Spans
+*  of the same kind that line up on consecutive rows go out as a single
+*  rectangle.
+*/
+
+#include "Adafruit_GFX.h"
+#include "Adafruit_SSD1351.h"
+#include "oled_sprite.h"
+
+// SETCOLUMN, SETROW and WRITERAM with their arguments, per fillRect()
+#define WINDOW_BYTES  7
+
+// pending rectangles, one for each side of the erase and paint spans
+#define ERASE_LEFT   0
+#define ERASE_RIGHT  1
+#define PAINT_LEFT   2
+#define PAINT_RIGHT  3
+
+typedef struct {
+  int x0, x1, y0, y1;
+  int valid;
+} SpanRect;
+
+unsigned long spritePixels, spriteBytes;
+unsigned long spriteFullPixels, spriteFullBytes;
+
+static SpanRect pending[4];
+
+
+static void fillClipped(int x0, int y0, int x1, int y1, unsigned int color) {
+  if (x0 < 0) x0 = 0;
+  if (y0 < 0) y0 = 0;
+  if (x1 > SSD1351WIDTH - 1) x1 = SSD1351WIDTH - 1;
+  if (y1 > SSD1351HEIGHT - 1) y1 = SSD1351HEIGHT - 1;
+  if (x0 > x1 || y0 > y1) return;
+
+  fillRect(x0, y0, x1 - x0 + 1, y1 - y0 + 1, color);
+  spritePixels += (unsigned long)(x1 - x0 + 1) * (y1 - y0 + 1);
+  spriteBytes += WINDOW_BYTES + 2 * (unsigned long)(x1 - x0 + 1) * (y1 - y0 + 1);
+}
+
+static void flushSpan(int kind, unsigned int color) {
+  SpanRect *p = &pending[kind];
+
+  if (p->valid) {
+    fillClipped(p->x0, p->y0, p->x1, p->y1, color);
+    p->valid = 0;
+  }
+}
+
+// Add columns x0..x1 of row y to the pending rectangle of this kind
+static void addSpan(int kind, int x0, int x1, int y, unsigned int color) {
+  SpanRect *p = &pending[kind];
+
+  if (x0 > x1) return;
+
+  if (p->valid && p->x0 == x0 && p->x1 == x1 && p->y1 == y - 1) {
+    p->y1 = y;
+    return;
+  }
+  flushSpan(kind, color);
+  p->x0 = x0;
+  p->x1 = x1;
+  p->y0 = p->y1 = y;
+  p->valid = 1;
+}
+
+// Columns of row y covered by a radius r circle at (x, y0); 0 if none
+static int rowSpan(const unsigned char *spans, int x, int y0, int r, int y,
+                   int *x0, int *x1) {
+  int dy = y - y0;
+
+  if (r < 0 || dy < -r || dy > r) return 0;
+  if (dy < 0) dy = -dy;
+
+  *x0 = x - spans[dy];
+  *x1 = x + spans[dy];
+  return 1;
+}
+
+// Pixels and SPI bytes fillCircle() spends on a radius r circle
+static void circleCost(int r, unsigned long *pixels, unsigned long *bytes) {
+  unsigned char buf[SSD1351WIDTH];
+  const unsigned char *spans;
+  int a, b;
+
+  if (r < 0) return;
+
+  spans = circleSpans(r, buf);
+  for (a = 0; a <= r; a = b + 1) {
+    unsigned long n;
+
+    for (b = a; b < r && spans[b+1] == spans[a]; b++) ;
+    n = (unsigned long)(b - a + 1) * (2 * spans[a] + 1);
+
+    if (a == 0) {
+      n = 2 * n - (2 * spans[a] + 1);   // center run covers both sides
+      *bytes += WINDOW_BYTES;
+    } else {
+      n *= 2;
+      *bytes += 2 * WINDOW_BYTES;
+    }
+    *pixels += n;
+    *bytes += 2 * n;
+  }
+}
+
+void spriteInit(Sprite *s, unsigned int color, unsigned int bg) {
+  s->x = 0;
+  s->y = 0;
+  s->r = -1;
+  s->color = color;
+  s->bg = bg;
+}
+
+void spriteMove(Sprite *s, int x, int y, int r) {
+  unsigned char oldBuf[SSD1351WIDTH], newBuf[SSD1351WIDTH];
+  const unsigned char *oldSpans = 0, *newSpans = 0;
+  int top, bottom, row;
+  int oa, ob, na, nb;
+  int inOld, inNew;
+
+  spritePixels = spriteBytes = 0;
+  spriteFullPixels = spriteFullBytes = 0;
+
+  if (r >= SSD1351WIDTH) r = SSD1351WIDTH - 1;
+  if (x == s->x && y == s->y && r == s->r) return;
+
+  circleCost(s->r, &spriteFullPixels, &spriteFullBytes);
+  circleCost(r, &spriteFullPixels, &spriteFullBytes);
+
+  if (s->r >= 0) oldSpans = circleSpans(s->r, oldBuf);
+  if (r >= 0) newSpans = circleSpans(r, newBuf);
+
+  // rows covered by either footprint
+  top = (s->r < 0 || (r >= 0 && y - r < s->y - s->r)) ? y - r : s->y - s->r;
+  bottom = (s->r < 0 || (r >= 0 && y + r > s->y + s->r)) ? y + r : s->y + s->r;
+
+  for (row = top; row <= bottom; row++) {
+    inOld = rowSpan(oldSpans, s->x, s->y, s->r, row, &oa, &ob);
+    inNew = rowSpan(newSpans, x, y, r, row, &na, &nb);
+
+    if (inOld && !inNew) {
+      addSpan(ERASE_LEFT, oa, ob, row, s->bg);
+    } else if (inOld) {
+      addSpan(ERASE_LEFT, oa, (ob < na - 1) ? ob : na - 1, row, s->bg);
+      addSpan(ERASE_RIGHT, (oa > nb + 1) ? oa : nb + 1, ob, row, s->bg);
+    }
+
+    if (inNew && !inOld) {
+      addSpan(PAINT_LEFT, na, nb, row, s->color);
+    } else if (inNew) {
+      addSpan(PAINT_LEFT, na, (nb < oa - 1) ? nb : oa - 1, row, s->color);
+      addSpan(PAINT_RIGHT, (na > ob + 1) ? na : ob + 1, nb, row, s->color);
+    }
+  }
+
+  flushSpan(ERASE_LEFT, s->bg);
+  flushSpan(ERASE_RIGHT, s->bg);
+  flushSpan(PAINT_LEFT, s->color);
+  flushSpan(PAINT_RIGHT, s->color);
+
+  s->x = x;
+  s->y = y;
+  s->r = r;
+}
+
+void spriteHide(Sprite *s) {
+  spriteMove(s, s->x, s->y, -1);
+}
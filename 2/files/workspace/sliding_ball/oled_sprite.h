@@ -0,0 +1,33 @@
+/*
+ * oled_sprite.h
+ *
+ *  Filled-circle sprites that move by repainting only the pixels that
+ *  leave or join the shape, instead of erasing and redrawing all of it.
+ */
+
+#ifndef OLED_OLED_SPRITE_H_
+#define OLED_OLED_SPRITE_H_
+
+typedef struct {
+  int x, y;             // center
+  int r;                // radius, -1 while not on screen
+  unsigned int color;
+  unsigned int bg;      // what is left behind
+} Sprite;
+
+void spriteInit(Sprite *s, unsigned int color, unsigned int bg);
+
+// Move and resize the sprite, painting the symmetric difference between
+// the old and new footprints. Nothing is sent if neither changed.
+void spriteMove(Sprite *s, int x, int y, int r);
+
+// Erase the sprite back to its background
+void spriteHide(Sprite *s);
+
+// Cost of the last spriteMove()/spriteHide(): pixels painted and SPI bytes
+// sent, next to what erasing and redrawing the whole circle would take
+extern unsigned long spritePixels, spriteBytes;
+extern unsigned long spriteFullPixels, spriteFullBytes;
+
+
+#endif /* OLED_OLED_SPRITE_H_ */
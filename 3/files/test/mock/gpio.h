@@ -0,0 +1,9 @@
+/* gpio.h (host mock) */
+
+#ifndef MOCK_GPIO_H_
+#define MOCK_GPIO_H_
+
+void GPIOPinWrite(unsigned long ulPort, unsigned char ucPins,
+                  unsigned char ucVal);
+
+#endif /* MOCK_GPIO_H_ */
@@ -0,0 +1,6 @@
+/* hw_common_reg.h (host mock): nothing the driver needs */
+
+#ifndef MOCK_HW_COMMON_REG_H_
+#define MOCK_HW_COMMON_REG_H_
+
+#endif /* MOCK_HW_COMMON_REG_H_ */
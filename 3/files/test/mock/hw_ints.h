@@ -0,0 +1,8 @@
+/* hw_ints.h (host mock) */
+
+#ifndef MOCK_HW_INTS_H_
+#define MOCK_HW_INTS_H_
+
+#define INT_GSPI  49
+
+#endif /* MOCK_HW_INTS_H_ */
@@ -0,0 +1,26 @@
+/* hw_mcspi.h (host mock): the channel 0 registers the driver touches */
+
+#ifndef MOCK_HW_MCSPI_H_
+#define MOCK_HW_MCSPI_H_
+
+#define MCSPI_O_CH0CONF        0x0000012C
+#define MCSPI_O_CH0STAT        0x00000130
+#define MCSPI_O_CH0CTRL        0x00000134
+#define MCSPI_O_TX0            0x00000138
+#define MCSPI_O_RX0            0x0000013C
+
+#define MCSPI_CH0CONF_WL_M     0x00000F80
+#define MCSPI_CH0CONF_WL_S     7
+#define MCSPI_CH0CONF_TRM_M    0x00003000
+#define MCSPI_CH0CONF_TRM_S    12
+#define MCSPI_CH0CONF_TURBO    0x00080000
+#define MCSPI_CH0CONF_FFEW     0x08000000
+#define MCSPI_CH0CONF_FFER     0x10000000
+
+#define MCSPI_CH0STAT_TXFFE    0x00000020
+#define MCSPI_CH0STAT_TXFFF    0x00000010
+#define MCSPI_CH0STAT_EOT      0x00000004
+#define MCSPI_CH0STAT_TXS      0x00000002
+#define MCSPI_CH0STAT_RXS      0x00000001
+
+#endif /* MOCK_HW_MCSPI_H_ */
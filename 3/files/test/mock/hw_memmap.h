@@ -0,0 +1,17 @@
+/* hw_memmap.h (host mock) */
+
+#ifndef MOCK_HW_MEMMAP_H_
+#define MOCK_HW_MEMMAP_H_
+
+#define GPIOA0_BASE   0x40004000
+#define GPIOA1_BASE   0x40005000
+#define GPIOA2_BASE   0x40006000
+#define GPIOA3_BASE   0x40007000
+#define UARTA0_BASE   0x4000C000
+#define TIMERA0_BASE  0x40030000
+#define TIMERA1_BASE  0x40031000
+#define TIMERA2_BASE  0x40032000
+#define TIMERA3_BASE  0x40033000
+#define GSPI_BASE     0x44021000
+
+#endif /* MOCK_HW_MEMMAP_H_ */
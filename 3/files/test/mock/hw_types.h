@@ -0,0 +1,20 @@
+/*
+ * hw_types.h (host mock)
+ *
+ *  Register accesses go to the mock's register file instead of memory.
+ */
+
+#ifndef MOCK_HW_TYPES_H_
+#define MOCK_HW_TYPES_H_
+
+typedef unsigned char tBoolean;
+
+#ifndef true
+#define true  1
+#define false 0
+#endif
+
+unsigned long *mockRegister(unsigned long addr);
+#define HWREG(x)  (*mockRegister((unsigned long)(x)))
+
+#endif /* MOCK_HW_TYPES_H_ */
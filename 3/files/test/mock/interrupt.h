@@ -0,0 +1,10 @@
+/* interrupt.h (host mock) */
+
+#ifndef MOCK_INTERRUPT_H_
+#define MOCK_INTERRUPT_H_
+
+// Both return whether interrupts were masked before the call
+tBoolean IntMasterEnable(void);
+tBoolean IntMasterDisable(void);
+
+#endif /* MOCK_INTERRUPT_H_ */
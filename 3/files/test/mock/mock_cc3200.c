@@ -0,0 +1,482 @@
+/* Host mock of the CC3200 peripherals behind the SSD1351 driver.
+*
+*  The SPI shifts each word out MSB first as 8-bit bytes, tagged with the
+*  level of the DC pin, into a model of the controller: a command decoder
+*  that knows how many argument bytes each command takes, and the 128x128
+*  display RAM with its column/row window and write pointer.
+*
+*  SIGALRM plays the part of the interrupt controller. A tick first lets
+*  the uDMA move MOCK_DMA_BURST items, as it would in the background, then
+*  enters the GSPI handler if a DMA-done interrupt is pending and
+*  interrupts are not masked. A tick that lands inside a mock call is
+*  dropped, the way a peripheral register access is never torn in half.
+*/
+
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "hw_types.h"
+#include "hw_memmap.h"
+#include "hw_mcspi.h"
+#include "gpio.h"
+#include "spi.h"
+#include "udma.h"
+#include "udma_if.h"
+#include "interrupt.h"
+#include "prcm.h"
+#include "timer.h"
+#include "timer_if.h"
+#include "utils.h"
+#include "uart_if.h"
+
+#include "mock_cc3200.h"
+
+
+#define MOCK_DMA_BURST  64      // items moved per tick
+#define MOCK_TICK_US    50
+
+#define DC_BASE     GPIOA0_BASE
+#define DC_PIN      0x40
+#define CS_BASE     GPIOA2_BASE
+#define CS_PIN      0x40
+#define RESET_BASE  GPIOA3_BASE
+#define RESET_PIN   0x80
+
+MockByte mockLog[MOCK_LOG_SIZE];
+volatile unsigned long mockLogLength;
+volatile unsigned long mockCollisions;
+volatile unsigned long mockErrors;
+volatile unsigned long mockCsCycles;
+
+static volatile sig_atomic_t inMock;     // a mock call is running
+static volatile sig_atomic_t inIsr;      // the GSPI handler is running
+static volatile sig_atomic_t masked;     // IntMasterDisable() in effect
+
+
+//*****************************************************************************
+// SSD1351 model
+
+static unsigned short ram[128][128];
+static int cmd, argsLeft, argCount, writeRam, highByte;
+static unsigned char args[8];
+static int col0, col1, row0, row1, col, row;
+static int remap, startLine;
+static int dcLevel, csLevel;
+
+static int argBytes(int c) {
+  switch (c) {
+  case 0x15: case 0x75:
+    return 2;
+  case 0xA0: case 0xA1: case 0xA2: case 0xAB: case 0xB1: case 0xB3:
+  case 0xB5: case 0xB6: case 0xBB: case 0xBE: case 0xC7: case 0xCA:
+  case 0xFD:
+    return 1;
+  case 0xB4: case 0xC1:
+    return 3;
+  default:
+    return 0;
+  }
+}
+
+static void panelReset(void) {
+  memset(ram, 0, sizeof(ram));
+  cmd = -1;
+  argsLeft = 0;
+  writeRam = 0;
+  highByte = -1;
+  col0 = 0;
+  col1 = 127;
+  row0 = 0;
+  row1 = 127;
+  col = 0;
+  row = 0;
+  remap = 0x40;
+  startLine = 0;
+}
+
+static void commandDone(void) {
+  switch (cmd) {
+  case 0x15: col0 = args[0]; col1 = args[1]; col = col0; break;
+  case 0x75: row0 = args[0]; row1 = args[1]; row = row0; break;
+  case 0xA0: remap = args[0]; break;
+  case 0xA1: startLine = args[0]; break;
+  }
+}
+
+// Horizontal or vertical address increment, wrapping inside the window
+static void advancePointer(void) {
+  if (remap & 0x01) {
+    if (++row > row1) {
+      row = row0;
+      if (++col > col1) col = col0;
+    }
+  } else {
+    if (++col > col1) {
+      col = col0;
+      if (++row > row1) row = row0;
+    }
+  }
+}
+
+static void panelByte(unsigned char b) {
+  if (mockLogLength < MOCK_LOG_SIZE) {
+    mockLog[mockLogLength].dc = dcLevel;
+    mockLog[mockLogLength].byte = b;
+    mockLogLength++;
+  }
+  if (csLevel) {
+    mockErrors++;
+    return;
+  }
+
+  if (!dcLevel) {
+    cmd = b;
+    writeRam = (b == 0x5C);
+    highByte = -1;
+    argCount = 0;
+    argsLeft = argBytes(b);
+    if (argsLeft == 0) commandDone();
+    return;
+  }
+  if (argsLeft > 0) {
+    args[argCount++] = b;
+    if (--argsLeft == 0) commandDone();
+    return;
+  }
+  if (!writeRam) {
+    mockErrors++;
+    return;
+  }
+  if (highByte < 0) {
+    highByte = b;
+    return;
+  }
+  ram[row][col] = (highByte << 8) | b;
+  highByte = -1;
+  advancePointer();
+}
+
+unsigned int mockPixel(int x, int y) {
+  int r = y, c = x;
+
+  if (!(remap & 0x10)) r = 127 - r;
+  if (remap & 0x02) c = 127 - c;
+  return ram[(r + startLine) & 127][c];
+}
+
+int mockCsHigh(void) {
+  return csLevel;
+}
+
+//*****************************************************************************
+// Registers and GSPI
+
+static unsigned long gspiRegs[0x200 / 4];
+static unsigned long otherReg;
+
+static unsigned long spiIntStatus, spiIntMask;
+static int spiEnabled, spiTxDma;
+static void (*spiHandler)(void);
+
+unsigned long *mockRegister(unsigned long addr) {
+  if (addr >= GSPI_BASE && addr < GSPI_BASE + sizeof(gspiRegs)) {
+    return &gspiRegs[(addr - GSPI_BASE) / 4];
+  }
+  return &otherReg;
+}
+
+// Shift one word out with the current word length
+static void spiShift(unsigned long word) {
+  unsigned long conf = HWREG(GSPI_BASE + MCSPI_O_CH0CONF);
+  int bits = ((conf & MCSPI_CH0CONF_WL_M) >> MCSPI_CH0CONF_WL_S) + 1;
+
+  if (bits % 8) {
+    mockErrors++;
+    return;
+  }
+  while (bits > 0) {
+    bits -= 8;
+    panelByte(word >> bits);
+  }
+}
+
+// The program touching the bus while uDMA is feeding it
+static void checkCollision(void) {
+  if (!inIsr && spiTxDma) mockCollisions++;
+}
+
+void SPIEnable(unsigned long ulBase) {
+  spiEnabled = 1;
+}
+
+void SPIDisable(unsigned long ulBase) {
+  spiEnabled = 0;
+}
+
+void SPIConfigSetExpClk(unsigned long ulBase, unsigned long ulSPIClk,
+                        unsigned long ulBitRate, unsigned long ulMode,
+                        unsigned long ulSubMode, unsigned long ulConfig) {
+  unsigned long keep = MCSPI_CH0CONF_WL_M | MCSPI_CH0CONF_TURBO;
+
+  inMock++;
+  HWREG(GSPI_BASE + MCSPI_O_CH0CONF) =
+      (HWREG(GSPI_BASE + MCSPI_O_CH0CONF) & ~keep) | (ulConfig & keep);
+  inMock--;
+}
+
+void SPIDataPut(unsigned long ulBase, unsigned long ulData) {
+  inMock++;
+  checkCollision();
+  spiShift(ulData);
+  inMock--;
+}
+
+void SPIDataGet(unsigned long ulBase, unsigned long *pulData) {
+  *pulData = 0;
+}
+
+void SPICSEnable(unsigned long ulBase) {
+}
+
+void SPICSDisable(unsigned long ulBase) {
+}
+
+void SPIDmaEnable(unsigned long ulBase, unsigned long ulFlags) {
+  if (ulFlags & SPI_TX_DMA) spiTxDma = 1;
+}
+
+void SPIDmaDisable(unsigned long ulBase, unsigned long ulFlags) {
+  if (ulFlags & SPI_TX_DMA) spiTxDma = 0;
+}
+
+void SPIIntRegister(unsigned long ulBase, void (*pfnHandler)(void)) {
+  spiHandler = pfnHandler;
+}
+
+void SPIIntEnable(unsigned long ulBase, unsigned long ulIntFlags) {
+  spiIntMask |= ulIntFlags;
+}
+
+void SPIIntDisable(unsigned long ulBase, unsigned long ulIntFlags) {
+  spiIntMask &= ~ulIntFlags;
+}
+
+unsigned long SPIIntStatus(unsigned long ulBase, tBoolean bMasked) {
+  return bMasked ? (spiIntStatus & spiIntMask) : spiIntStatus;
+}
+
+void SPIIntClear(unsigned long ulBase, unsigned long ulIntFlags) {
+  spiIntStatus &= ~ulIntFlags;
+}
+
+//*****************************************************************************
+// GPIO
+
+void GPIOPinWrite(unsigned long ulPort, unsigned char ucPins,
+                  unsigned char ucVal) {
+  inMock++;
+  if (ulPort == DC_BASE && (ucPins & DC_PIN)) {
+    checkCollision();
+    dcLevel = (ucVal & DC_PIN) != 0;
+  }
+  if (ulPort == CS_BASE && (ucPins & CS_PIN)) {
+    checkCollision();
+    if (csLevel && !(ucVal & CS_PIN)) mockCsCycles++;
+    csLevel = (ucVal & CS_PIN) != 0;
+  }
+  if (ulPort == RESET_BASE && (ucPins & RESET_PIN) && !(ucVal & RESET_PIN)) {
+    panelReset();
+  }
+  inMock--;
+}
+
+//*****************************************************************************
+// uDMA channel 31
+
+static struct {
+  unsigned long control;
+  const void *src;
+  unsigned long items;
+  unsigned long next;
+  int enabled;
+} channel;
+
+void UDMAInit(void) {
+}
+
+void uDMAChannelAssign(unsigned long ulMapping) {
+}
+
+void UDMASetupTransfer(unsigned long ulChannel, unsigned long ulMode,
+                       unsigned long ulItemCount, unsigned long ulItemSize,
+                       unsigned long ulArbSize, void *pvSrcBuf,
+                       unsigned long ulSrcInc, void *pvDstBuf,
+                       unsigned long ulDstInc) {
+  if (ulChannel != UDMA_CH31_GSPI_TX) return;
+
+  inMock++;
+  channel.control = ulItemSize | ulSrcInc;
+  channel.src = pvSrcBuf;
+  channel.items = ulItemCount;
+  channel.next = 0;
+  channel.enabled = 1;
+  inMock--;
+}
+
+tBoolean uDMAChannelIsEnabled(unsigned long ulChannelNum) {
+  return channel.enabled;
+}
+
+static unsigned long dmaItem(void) {
+  unsigned long k = channel.next;
+
+  if ((channel.control & UDMA_SRC_INC_NONE) == UDMA_SRC_INC_NONE) k = 0;
+  switch (channel.control & (UDMA_SIZE_16 | UDMA_SIZE_32)) {
+  case UDMA_SIZE_32:
+    return ((const unsigned int *)channel.src)[k];
+  case UDMA_SIZE_16:
+    return ((const unsigned short *)channel.src)[k];
+  default:
+    return ((const unsigned char *)channel.src)[k];
+  }
+}
+
+static void dmaRun(void) {
+  int n;
+
+  if (!channel.enabled || !spiTxDma || !spiEnabled) return;
+
+  for (n = 0; n < MOCK_DMA_BURST && channel.next < channel.items; n++) {
+    spiShift(dmaItem());
+    channel.next++;
+  }
+  if (channel.next == channel.items) {
+    channel.enabled = 0;
+    spiIntStatus |= SPI_INT_DMATX;
+  }
+}
+
+//*****************************************************************************
+// Interrupts
+
+static void tick(int sig) {
+  if (inMock) return;
+
+  dmaRun();
+  if (masked || !(spiIntStatus & spiIntMask) || !spiHandler) return;
+
+  inIsr = 1;
+  spiHandler();
+  inIsr = 0;
+}
+
+void mockInterruptsStart(void) {
+  struct sigaction sa;
+  struct itimerval t;
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = tick;
+  sa.sa_flags = SA_RESTART;
+  sigaction(SIGALRM, &sa, 0);
+
+  t.it_interval.tv_sec = 0;
+  t.it_interval.tv_usec = MOCK_TICK_US;
+  t.it_value = t.it_interval;
+  setitimer(ITIMER_REAL, &t, 0);
+}
+
+void mockInterruptsStop(void) {
+  struct itimerval t;
+
+  memset(&t, 0, sizeof(t));
+  setitimer(ITIMER_REAL, &t, 0);
+}
+
+tBoolean IntMasterEnable(void) {
+  tBoolean was = masked;
+
+  masked = 0;
+  return was;
+}
+
+tBoolean IntMasterDisable(void) {
+  tBoolean was = masked;
+
+  masked = 1;
+  return was;
+}
+
+//*****************************************************************************
+// Timers: a one-shot times out as soon as it is enabled
+
+static unsigned long timerStatus;
+
+void Timer_IF_Init(unsigned long ePeripheral, unsigned long ulBase,
+                   unsigned long ulConfig, unsigned long ulTimer,
+                   unsigned long ulValue) {
+  timerStatus = 0;
+}
+
+void TimerLoadSet(unsigned long ulBase, unsigned long ulTimer,
+                  unsigned long ulValue) {
+}
+
+void TimerEnable(unsigned long ulBase, unsigned long ulTimer) {
+  timerStatus |= TIMER_TIMA_TIMEOUT;
+}
+
+void TimerIntClear(unsigned long ulBase, unsigned long ulIntFlags) {
+  timerStatus &= ~ulIntFlags;
+}
+
+unsigned long TimerIntStatus(unsigned long ulBase, tBoolean bMasked) {
+  return timerStatus;
+}
+
+//*****************************************************************************
+// Everything else
+
+unsigned long PRCMPeripheralClockGet(unsigned long ulPeripheral) {
+  return 80000000;
+}
+
+void UtilsDelay(unsigned long ulCount) {
+}
+
+int Report(const char *pcFormat, ...) {
+  va_list ap;
+  int n;
+
+  va_start(ap, pcFormat);
+  n = vprintf(pcFormat, ap);
+  va_end(ap);
+  return n;
+}
+
+void mockLogClear(void) {
+  mockLogLength = 0;
+}
+
+void mockReset(void) {
+  mockInterruptsStop();
+  memset(gspiRegs, 0, sizeof(gspiRegs));
+  HWREG(GSPI_BASE + MCSPI_O_CH0CONF) = SPI_WL_8;
+  HWREG(GSPI_BASE + MCSPI_O_CH0STAT) =
+      MCSPI_CH0STAT_TXFFE | MCSPI_CH0STAT_EOT | MCSPI_CH0STAT_TXS;
+  spiIntStatus = 0;
+  spiIntMask = 0;
+  spiEnabled = 1;
+  spiTxDma = 0;
+  memset(&channel, 0, sizeof(channel));
+  masked = 0;
+  dcLevel = 0;
+  csLevel = 1;
+  panelReset();
+  mockLogClear();
+  mockCollisions = 0;
+  mockErrors = 0;
+  mockCsCycles = 0;
+}
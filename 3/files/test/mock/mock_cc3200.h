@@ -0,0 +1,49 @@
+/*
+ * mock_cc3200.h
+ *
+ *  Host stand-ins for the parts of the CC3200 the display driver uses:
+ *  GSPI channel 0, the DC/CS/RESET GPIOs, uDMA channel 31 and the GSPI
+ *  interrupt, wired to a model of the SSD1351 command decoder and RAM.
+ *
+ *  Interrupts come from an interval timer. Each tick the uDMA moves a few
+ *  items into the SPI, and when a channel finishes the registered GSPI
+ *  handler runs, exactly where the program happens to be, unless
+ *  interrupts are masked with IntMasterDisable(). Anything the program
+ *  itself puts on the bus while the SPI is taking words from uDMA is a
+ *  collision; on hardware it would be interleaved with the pixel stream.
+ */
+
+#ifndef MOCK_MOCK_CC3200_H_
+#define MOCK_MOCK_CC3200_H_
+
+#define MOCK_LOG_SIZE  8192
+
+typedef struct {
+  unsigned char dc;         // 0 command, 1 data
+  unsigned char byte;
+} MockByte;
+
+// Every byte the panel received since the last mockLogClear(), up to
+// MOCK_LOG_SIZE of them
+extern MockByte mockLog[MOCK_LOG_SIZE];
+extern volatile unsigned long mockLogLength;
+
+extern volatile unsigned long mockCollisions;  // program bus access during DMA
+extern volatile unsigned long mockErrors;      // bytes the panel could not take
+extern volatile unsigned long mockCsCycles;    // falling edges of CS
+
+// Puts the panel, the bus and the counters back to their power-on state
+void mockReset(void);
+void mockLogClear(void);
+
+// Starts and stops the interrupt ticks
+void mockInterruptsStart(void);
+void mockInterruptsStop(void);
+
+// Visible pixel at (x, y) in rotation 0
+unsigned int mockPixel(int x, int y);
+
+int mockCsHigh(void);
+
+
+#endif /* MOCK_MOCK_CC3200_H_ */
@@ -0,0 +1,6 @@
+/* pin_mux_config.h (host mock): nothing the driver needs */
+
+#ifndef MOCK_PIN_MUX_CONFIG_H_
+#define MOCK_PIN_MUX_CONFIG_H_
+
+#endif /* MOCK_PIN_MUX_CONFIG_H_ */
@@ -0,0 +1,11 @@
+/* prcm.h (host mock) */
+
+#ifndef MOCK_PRCM_H_
+#define MOCK_PRCM_H_
+
+#define PRCM_GSPI     0x00000016
+#define PRCM_TIMERA3  0x00000010
+
+unsigned long PRCMPeripheralClockGet(unsigned long ulPeripheral);
+
+#endif /* MOCK_PRCM_H_ */
@@ -0,0 +1,6 @@
+/* rom.h (host mock): nothing the driver needs */
+
+#ifndef MOCK_ROM_H_
+#define MOCK_ROM_H_
+
+#endif /* MOCK_ROM_H_ */
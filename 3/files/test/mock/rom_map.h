@@ -0,0 +1,32 @@
+/* rom_map.h (host mock): every MAP_ call goes to the mock */
+
+#ifndef MOCK_ROM_MAP_H_
+#define MOCK_ROM_MAP_H_
+
+#define MAP_SPIEnable               SPIEnable
+#define MAP_SPIDisable              SPIDisable
+#define MAP_SPIConfigSetExpClk      SPIConfigSetExpClk
+#define MAP_SPIDataPut              SPIDataPut
+#define MAP_SPIDataGet              SPIDataGet
+#define MAP_SPICSEnable             SPICSEnable
+#define MAP_SPICSDisable            SPICSDisable
+#define MAP_SPIDmaEnable            SPIDmaEnable
+#define MAP_SPIDmaDisable           SPIDmaDisable
+#define MAP_SPIIntRegister          SPIIntRegister
+#define MAP_SPIIntEnable            SPIIntEnable
+#define MAP_SPIIntDisable           SPIIntDisable
+#define MAP_SPIIntStatus            SPIIntStatus
+#define MAP_SPIIntClear             SPIIntClear
+#define MAP_GPIOPinWrite            GPIOPinWrite
+#define MAP_uDMAChannelAssign       uDMAChannelAssign
+#define MAP_uDMAChannelIsEnabled    uDMAChannelIsEnabled
+#define MAP_IntMasterEnable         IntMasterEnable
+#define MAP_IntMasterDisable        IntMasterDisable
+#define MAP_PRCMPeripheralClockGet  PRCMPeripheralClockGet
+#define MAP_UtilsDelay              UtilsDelay
+#define MAP_TimerLoadSet            TimerLoadSet
+#define MAP_TimerEnable             TimerEnable
+#define MAP_TimerIntClear           TimerIntClear
+#define MAP_TimerIntStatus          TimerIntStatus
+
+#endif /* MOCK_ROM_MAP_H_ */
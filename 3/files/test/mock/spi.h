@@ -0,0 +1,39 @@
+/* spi.h (host mock) */
+
+#ifndef MOCK_SPI_H_
+#define MOCK_SPI_H_
+
+#define SPI_MODE_MASTER       0x00000000
+#define SPI_SUB_MODE_0        0x00000000
+#define SPI_SW_CTRL_CS        0x01000000
+#define SPI_3PIN_MODE         0x02000000
+#define SPI_4PIN_MODE         0x00000000
+#define SPI_TURBO_ON          0x00080000
+#define SPI_TURBO_OFF         0x00000000
+#define SPI_CS_ACTIVEHIGH     0x00000000
+#define SPI_CS_ACTIVELOW      0x00000040
+#define SPI_WL_8              0x00000380
+#define SPI_WL_16             0x00000780
+#define SPI_WL_32             0x00000F80
+
+#define SPI_TX_DMA            0x00004000
+#define SPI_INT_DMATX         0x20000000
+
+void SPIEnable(unsigned long ulBase);
+void SPIDisable(unsigned long ulBase);
+void SPIConfigSetExpClk(unsigned long ulBase, unsigned long ulSPIClk,
+                        unsigned long ulBitRate, unsigned long ulMode,
+                        unsigned long ulSubMode, unsigned long ulConfig);
+void SPIDataPut(unsigned long ulBase, unsigned long ulData);
+void SPIDataGet(unsigned long ulBase, unsigned long *pulData);
+void SPICSEnable(unsigned long ulBase);
+void SPICSDisable(unsigned long ulBase);
+void SPIDmaEnable(unsigned long ulBase, unsigned long ulFlags);
+void SPIDmaDisable(unsigned long ulBase, unsigned long ulFlags);
+void SPIIntRegister(unsigned long ulBase, void (*pfnHandler)(void));
+void SPIIntEnable(unsigned long ulBase, unsigned long ulIntFlags);
+void SPIIntDisable(unsigned long ulBase, unsigned long ulIntFlags);
+unsigned long SPIIntStatus(unsigned long ulBase, tBoolean bMasked);
+void SPIIntClear(unsigned long ulBase, unsigned long ulIntFlags);
+
+#endif /* MOCK_SPI_H_ */
@@ -0,0 +1,16 @@
+/* timer.h (host mock) */
+
+#ifndef MOCK_TIMER_H_
+#define MOCK_TIMER_H_
+
+#define TIMER_CFG_ONE_SHOT   0x00000021
+#define TIMER_A              0x000000ff
+#define TIMER_TIMA_TIMEOUT   0x00000001
+
+void TimerLoadSet(unsigned long ulBase, unsigned long ulTimer,
+                  unsigned long ulValue);
+void TimerEnable(unsigned long ulBase, unsigned long ulTimer);
+void TimerIntClear(unsigned long ulBase, unsigned long ulIntFlags);
+unsigned long TimerIntStatus(unsigned long ulBase, tBoolean bMasked);
+
+#endif /* MOCK_TIMER_H_ */
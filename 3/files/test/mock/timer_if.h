@@ -0,0 +1,10 @@
+/* timer_if.h (host mock) */
+
+#ifndef MOCK_TIMER_IF_H_
+#define MOCK_TIMER_IF_H_
+
+void Timer_IF_Init(unsigned long ePeripheral, unsigned long ulBase,
+                   unsigned long ulConfig, unsigned long ulTimer,
+                   unsigned long ulValue);
+
+#endif /* MOCK_TIMER_IF_H_ */
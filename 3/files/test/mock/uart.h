@@ -0,0 +1,6 @@
+/* uart.h (host mock): nothing the driver needs */
+
+#ifndef MOCK_UART_H_
+#define MOCK_UART_H_
+
+#endif /* MOCK_UART_H_ */
@@ -0,0 +1,8 @@
+/* uart_if.h (host mock) */
+
+#ifndef MOCK_UART_IF_H_
+#define MOCK_UART_IF_H_
+
+int Report(const char *pcFormat, ...);
+
+#endif /* MOCK_UART_IF_H_ */
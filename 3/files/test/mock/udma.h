@@ -0,0 +1,22 @@
+/* udma.h (host mock) */
+
+#ifndef MOCK_UDMA_H_
+#define MOCK_UDMA_H_
+
+#define UDMA_CH31_GSPI_TX   0x0000001F
+
+#define UDMA_MODE_BASIC     0x00000001
+#define UDMA_SIZE_8         0x00000000
+#define UDMA_SIZE_16        0x11000000
+#define UDMA_SIZE_32        0x22000000
+#define UDMA_SRC_INC_8      0x00000000
+#define UDMA_SRC_INC_16     0x04000000
+#define UDMA_SRC_INC_32     0x08000000
+#define UDMA_SRC_INC_NONE   0x0c000000
+#define UDMA_DST_INC_NONE   0xc0000000
+#define UDMA_ARB_1          0x00000000
+
+void uDMAChannelAssign(unsigned long ulMapping);
+tBoolean uDMAChannelIsEnabled(unsigned long ulChannelNum);
+
+#endif /* MOCK_UDMA_H_ */
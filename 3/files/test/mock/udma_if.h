@@ -0,0 +1,13 @@
+/* udma_if.h (host mock) */
+
+#ifndef MOCK_UDMA_IF_H_
+#define MOCK_UDMA_IF_H_
+
+void UDMAInit(void);
+void UDMASetupTransfer(unsigned long ulChannel, unsigned long ulMode,
+                       unsigned long ulItemCount, unsigned long ulItemSize,
+                       unsigned long ulArbSize, void *pvSrcBuf,
+                       unsigned long ulSrcInc, void *pvDstBuf,
+                       unsigned long ulDstInc);
+
+#endif /* MOCK_UDMA_IF_H_ */
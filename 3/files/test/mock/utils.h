@@ -0,0 +1,8 @@
+/* utils.h (host mock) */
+
+#ifndef MOCK_UTILS_H_
+#define MOCK_UTILS_H_
+
+void UtilsDelay(unsigned long ulCount);
+
+#endif /* MOCK_UTILS_H_ */
@@ -0,0 +1,184 @@
+/* Host test for the DMA pixel pump in oled_dma.c.
+*
+*  Runs the real driver against the mock in mock/, with the uDMA and the
+*  GSPI interrupt advancing on their own, and checks what reached the
+*  panel: the exact bytes of a small fill, the image left by fills and
+*  buffer pushes that take several uDMA chunks, and blocking draws issued
+*  while a transfer is still running, which must wait for it instead of
+*  writing over the pixel stream.
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Adafruit_SSD1351.h"
+#include "Adafruit_GFX.h"
+#include "oled_dma.h"
+#include "mock_cc3200.h"
+
+
+#define BLACK   0x0000
+#define BLUE    0x001F
+#define GREEN   0x07E0
+#define RED     0xF800
+#define YELLOW  0xFFE0
+#define WHITE   0xFFFF
+
+static int failures;
+static volatile int doneCalls;
+
+static unsigned short expected[SSD1351HEIGHT][SSD1351WIDTH];
+
+#define CHECK(cond)  check((cond), #cond, __LINE__)
+
+static void check(int ok, const char *what, int line) {
+  if (ok) return;
+  printf("  line %d: %s\n", line, what);
+  failures++;
+}
+
+static void done(void) {
+  doneCalls++;
+}
+
+static void expectRect(int x, int y, int w, int h, unsigned short color) {
+  int i, j;
+
+  for (j = y; j < y + h; j++) {
+    for (i = x; i < x + w; i++) {
+      expected[j][i] = color;
+    }
+  }
+}
+
+static int imageMismatches(void) {
+  int x, y, n = 0;
+
+  for (y = 0; y < SSD1351HEIGHT; y++) {
+    for (x = 0; x < SSD1351WIDTH; x++) {
+      if (mockPixel(x, y) != expected[y][x]) n++;
+    }
+  }
+  return n;
+}
+
+// Power-on, Adafruit_Init() and a black screen, with interrupts running
+static void setUp(void) {
+  mockReset();
+  Adafruit_Init();
+  displayDMAInit();
+  fillScreen(BLACK);
+  expectRect(0, 0, SSD1351WIDTH, SSD1351HEIGHT, BLACK);
+  doneCalls = 0;
+  mockLogClear();
+  mockInterruptsStart();
+}
+
+static void tearDown(void) {
+  mockInterruptsStop();
+  CHECK(!displayDMABusy());
+  CHECK(mockCsHigh());
+  CHECK(mockErrors == 0);
+  CHECK(mockCollisions == 0);
+  CHECK(imageMismatches() == 0);
+}
+
+//*****************************************************************************
+
+// A 2x2 fill is the window commands followed by four pixels, all in one
+// CS cycle
+static void testFillBytes(void) {
+  static const MockByte bytes[] = {
+    { 0, 0x15 }, { 1, 4 }, { 1, 5 },
+    { 0, 0x75 }, { 1, 8 }, { 1, 9 },
+    { 0, 0x5C },
+    { 1, 0xF8 }, { 1, 0x00 }, { 1, 0xF8 }, { 1, 0x00 },
+    { 1, 0xF8 }, { 1, 0x00 }, { 1, 0xF8 }, { 1, 0x00 },
+  };
+  unsigned long n = sizeof(bytes) / sizeof(bytes[0]);
+  unsigned long cycles;
+
+  setUp();
+  cycles = mockCsCycles;
+  CHECK(fillRectAsync(4, 8, 2, 2, RED, done));
+  displayDMAWait();
+  expectRect(4, 8, 2, 2, RED);
+
+  CHECK(doneCalls == 1);
+  CHECK(mockCsCycles == cycles + 1);
+  CHECK(mockLogLength == n);
+  CHECK(memcmp(mockLog, bytes, sizeof(bytes)) == 0);
+  tearDown();
+}
+
+// A push and a full-screen fill both span several 1024-item chunks
+static void testImages(void) {
+  static unsigned short pixels[30][40];
+  int x, y;
+
+  for (y = 0; y < 30; y++) {
+    for (x = 0; x < 40; x++) {
+      pixels[y][x] = (y << 11) | (x << 5) | ((x + y) & 0x1F);
+    }
+  }
+
+  setUp();
+  CHECK(pushColorsAsync(50, 60, 40, 30, &pixels[0][0], done));
+  displayDMAWait();
+  for (y = 0; y < 30; y++) {
+    for (x = 0; x < 40; x++) {
+      expected[60 + y][50 + x] = pixels[y][x];
+    }
+  }
+  CHECK(doneCalls == 1);
+  CHECK(mockLogLength == 7 + 2 * 40 * 30);
+  CHECK(imageMismatches() == 0);
+
+  // the window shadow has to follow the pointer the transfer moved
+  drawPixel(3, 3, WHITE);
+  expected[3][3] = WHITE;
+  CHECK(imageMismatches() == 0);
+
+  CHECK(fillScreenAsync(BLUE, done));
+  displayDMAWait();
+  expectRect(0, 0, SSD1351WIDTH, SSD1351HEIGHT, BLUE);
+  CHECK(doneCalls == 2);
+  tearDown();
+}
+
+// Blocking draws made while a transfer is running, outside and inside an
+// open transaction, have to wait for it
+static void testDrawDuringTransfer(void) {
+  setUp();
+  CHECK(fillScreenAsync(BLUE, done));
+  CHECK(displayDMABusy());
+  fillRect(10, 10, 20, 20, RED);
+  expectRect(0, 0, SSD1351WIDTH, SSD1351HEIGHT, BLUE);
+  expectRect(10, 10, 20, 20, RED);
+
+  startWrite();
+  CHECK(fillRectAsync(40, 40, 30, 30, YELLOW, done));
+  CHECK(displayDMABusy());
+  drawFastHLine(40, 44, 30, WHITE);
+  drawPixel(1, 1, GREEN);
+  endWrite();
+  expectRect(40, 40, 30, 30, YELLOW);
+  expectRect(40, 44, 30, 1, WHITE);
+  expected[1][1] = GREEN;
+
+  displayDMAWait();
+  CHECK(doneCalls == 2);
+  tearDown();
+}
+
+int main(void) {
+  printf("fill bytes\n");
+  testFillBytes();
+  printf("images\n");
+  testImages();
+  printf("draw during transfer\n");
+  testDrawDuringTransfer();
+
+  printf(failures ? "FAILED (%d)\n" : "passed\n", failures);
+  return failures != 0;
+}
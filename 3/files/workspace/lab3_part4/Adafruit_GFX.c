@@ -31,9 +31,15 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <stdlib.h>
+
 #include "Adafruit_GFX.h"
 #include "Adafruit_SSD1351.h"
 #include "glcdfont.h"
+#include "oled_band.h"
+#include "oled_framebuffer.h"
+#include "oled_glyphcache.h"
+#include "oled_textlayout.h"
 //#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
 
 int cursor_x=0;
@@ -43,6 +49,11 @@ unsigned int textcolor = 0xFFFF;
 unsigned int textbgcolor = 0xFFFF;
 char wrap = 1;
 
+// display size as modified by the current rotation
+static int _width = WIDTH;
+static int _height = HEIGHT;
+static unsigned char rotation = 0;
+
 
 /*
 Adafruit_GFX(int w, int h):
@@ -58,47 +69,213 @@ Adafruit_GFX(int w, int h):
 }
 */
 
-// Draw a circle outline
-void drawCircle(int x0, int y0, int r, unsigned int color) {
-  int f = 1 - r;
+// Clip rectangle
+//
+// Everything drawn is trimmed to this rectangle, x0..x1-1 by y0..y1-1. It
+// covers the whole screen until setClipRect() narrows it; setRotation()
+// resets it. Primitives trim or reject each shape once, up front, so a
+// widget drawing into a small region costs nothing outside it.
+
+static int clipX0 = 0, clipY0 = 0, clipX1 = WIDTH, clipY1 = HEIGHT;
+
+void setClipRect(int x, int y, int w, int h) {
+  clipX0 = (x < 0) ? 0 : x;
+  clipY0 = (y < 0) ? 0 : y;
+  clipX1 = (x + w > _width) ? _width : x + w;
+  clipY1 = (y + h > _height) ? _height : y + h;
+
+  // an empty rectangle clips everything
+  if (clipX1 < clipX0) clipX1 = clipX0;
+  if (clipY1 < clipY0) clipY1 = clipY0;
+}
+
+void clearClipRect(void) {
+  setClipRect(0, 0, _width, _height);
+}
+
+void getClipRect(int *x, int *y, int *w, int *h) {
+  *x = clipX0;
+  *y = clipY0;
+  *w = clipX1 - clipX0;
+  *h = clipY1 - clipY0;
+}
+
+// Trim a rectangle to the clip rectangle. Returns 0 if nothing is left.
+int clipRect(int *x, int *y, int *w, int *h) {
+  if (*x < clipX0) { *w -= clipX0 - *x; *x = clipX0; }
+  if (*y < clipY0) { *h -= clipY0 - *y; *y = clipY0; }
+  if (*x + *w > clipX1) *w = clipX1 - *x;
+  if (*y + *h > clipY1) *h = clipY1 - *y;
+
+  return (*w > 0) && (*h > 0);
+}
+
+int clipContains(int x, int y) {
+  return (x >= clipX0) && (x < clipX1) && (y >= clipY0) && (y < clipY1);
+}
+
+// True if the box x0..x1, y0..y1 (inclusive) lies wholly outside the clip
+static int clipRejects(int x0, int y0, int x1, int y1) {
+  return (x1 < clipX0) || (x0 >= clipX1) || (y1 < clipY0) || (y0 >= clipY1);
+}
+
+// Outline spans
+//
+// The Bresenham circle loop walks one octant from the top of the circle
+// towards the diagonal. Points that share a row form a horizontal run, and
+// the same run transposed is a vertical run on the side of the circle, so
+// each quadrant is drawn as one span per run instead of one pixel per
+// point. In direct mode the whole outline goes out in one transaction.
+
+#define QUAD_TL  0x1
+#define QUAD_TR  0x2
+#define QUAD_BR  0x4
+#define QUAD_BL  0x8
+
+// Horizontal span x0..x1 on row y, clipped
+static void outlineHSpan(int x0, int x1, int y, unsigned int color) {
+  if (x0 == x1) {
+    drawPixel(x0, y, color);
+  } else {
+    fillRect(x0, y, x1 - x0 + 1, 1, color);
+  }
+}
+
+// Vertical span y0..y1 in column x, clipped
+static void outlineVSpan(int x, int y0, int y1, unsigned int color) {
+  if (y0 == y1) {
+    drawPixel(x, y0, color);
+  } else {
+    fillRect(x, y0, 1, y1 - y0 + 1, color);
+  }
+}
+
+// Draw the run x = a..b at height y, and its transpose, in each quadrant.
+// Runs that start on an axis are joined with their mirror image.
+static void outlineRun(int x0, int y0, int a, int b, int y,
+                       unsigned char quads, unsigned int color) {
+  unsigned char top = quads & (QUAD_TL | QUAD_TR);
+  unsigned char bottom = quads & (QUAD_BL | QUAD_BR);
+  unsigned char left = quads & (QUAD_TL | QUAD_BL);
+  unsigned char right = quads & (QUAD_TR | QUAD_BR);
+
+  // rows above and below the center
+  if (a == 0 && top == (QUAD_TL | QUAD_TR)) {
+    outlineHSpan(x0 - b, x0 + b, y0 - y, color);
+  } else {
+    if (quads & QUAD_TL) outlineHSpan(x0 - b, x0 - a, y0 - y, color);
+    if (quads & QUAD_TR) outlineHSpan(x0 + a, x0 + b, y0 - y, color);
+  }
+  if (a == 0 && bottom == (QUAD_BL | QUAD_BR)) {
+    outlineHSpan(x0 - b, x0 + b, y0 + y, color);
+  } else {
+    if (quads & QUAD_BL) outlineHSpan(x0 - b, x0 - a, y0 + y, color);
+    if (quads & QUAD_BR) outlineHSpan(x0 + a, x0 + b, y0 + y, color);
+  }
+
+  // columns left and right of the center
+  if (a == 0 && left == (QUAD_TL | QUAD_BL)) {
+    outlineVSpan(x0 - y, y0 - b, y0 + b, color);
+  } else {
+    if (quads & QUAD_TL) outlineVSpan(x0 - y, y0 - b, y0 - a, color);
+    if (quads & QUAD_BL) outlineVSpan(x0 - y, y0 + a, y0 + b, color);
+  }
+  if (a == 0 && right == (QUAD_TR | QUAD_BR)) {
+    outlineVSpan(x0 + y, y0 - b, y0 + b, color);
+  } else {
+    if (quads & QUAD_TR) outlineVSpan(x0 + y, y0 - b, y0 - a, color);
+    if (quads & QUAD_BR) outlineVSpan(x0 + y, y0 + a, y0 + b, color);
+  }
+}
+
+// Outline of the quadrants in quads. first is 0 to include the points on
+// the axes, as drawCircle() does, or 1 to start next to them.
+static void circleOutline(int x0, int y0, int r, unsigned char quads,
+                          int first, unsigned int color) {
+  int f     = 1 - r;
   int ddF_x = 1;
   int ddF_y = -2 * r;
-  int x = 0;
-  int y = r;
+  int x     = 0;
+  int y     = r;
+  int runStart = -1, runY = r;
 
-  drawPixel(x0  , y0+r, color);
-  drawPixel(x0  , y0-r, color);
-  drawPixel(x0+r, y0  , color);
-  drawPixel(x0-r, y0  , color);
+  if (first == 0) runStart = 0;
 
   while (x<y) {
     if (f >= 0) {
       y--;
       ddF_y += 2;
-      f += ddF_y;
+      f     += ddF_y;
     }
     x++;
     ddF_x += 2;
-    f += ddF_x;
-  
-    drawPixel(x0 + x, y0 + y, color);
-    drawPixel(x0 - x, y0 + y, color);
-    drawPixel(x0 + x, y0 - y, color);
-    drawPixel(x0 - x, y0 - y, color);
-    drawPixel(x0 + y, y0 + x, color);
-    drawPixel(x0 - y, y0 + x, color);
-    drawPixel(x0 + y, y0 - x, color);
-    drawPixel(x0 - y, y0 - x, color);
+    f     += ddF_x;
+
+    if (runStart >= 0 && y != runY) {
+      outlineRun(x0, y0, runStart, x - 1, runY, quads, color);
+      runStart = -1;
+    }
+    if (runStart < 0) {
+      runStart = x;
+      runY = y;
+    }
+  }
+  if (runStart >= 0) {
+    outlineRun(x0, y0, runStart, x, runY, quads, color);
   }
 }
 
+// Draw a circle outline
+void drawCircle(int x0, int y0, int r, unsigned int color) {
+  if (clipRejects(x0 - r, y0 - r, x0 + r, y0 + r)) return;
+
+#ifndef SSD1351_FRAMEBUFFER
+  startWrite();
+#endif
+  circleOutline(x0, y0, r, QUAD_TL | QUAD_TR | QUAD_BR | QUAD_BL, 0, color);
+#ifndef SSD1351_FRAMEBUFFER
+  endWrite();
+#endif
+}
+
 void drawCircleHelper( int x0, int y0,
                int r, unsigned char cornername, unsigned int color) {
+  // cornername uses the QUAD_ bits
+  circleOutline(x0, y0, r, cornername, 1, color);
+}
+
+// Half-heights of the columns of a filled circle for dx = 0..r, the same
+// pixels the Bresenham loop in fillCircleHelper() covers. Radii up to
+// CIRCLE_TABLE_RADIUS are precomputed; radius r starts at r*(r+1)/2.
+#define CIRCLE_TABLE_RADIUS  10
+static const unsigned char circleSpanTable[] = {
+  0,
+  1, 0,
+  2, 2, 1,
+  3, 3, 2, 1,
+  4, 4, 3, 3, 1,
+  5, 5, 5, 4, 3, 2,
+  6, 6, 6, 5, 4, 3, 2,
+  7, 7, 7, 6, 6, 5, 4, 2,
+  8, 8, 8, 7, 7, 6, 5, 4, 2,
+  9, 9, 9, 8, 8, 7, 7, 6, 4, 2,
+  10, 10, 10, 10, 9, 9, 8, 7, 6, 5, 3
+};
+
+// Column half-heights for radius r, from the table or worked out into buf
+// (r+1 entries)
+const unsigned char *getCircleSpans(int r, unsigned char *buf) {
   int f     = 1 - r;
   int ddF_x = 1;
   int ddF_y = -2 * r;
   int x     = 0;
   int y     = r;
+  int i;
+
+  if (r <= CIRCLE_TABLE_RADIUS) return &circleSpanTable[r*(r+1)/2];
+
+  buf[0] = r;
+  for (i = 1; i <= r; i++) buf[i] = 0;
 
   while (x<y) {
     if (f >= 0) {
@@ -109,27 +286,48 @@ void drawCircleHelper( int x0, int y0,
     x++;
     ddF_x += 2;
     f     += ddF_x;
-    if (cornername & 0x4) {
-      drawPixel(x0 + x, y0 + y, color);
-      drawPixel(x0 + y, y0 + x, color);
-    } 
-    if (cornername & 0x2) {
-      drawPixel(x0 + x, y0 - y, color);
-      drawPixel(x0 + y, y0 - x, color);
-    }
-    if (cornername & 0x8) {
-      drawPixel(x0 - y, y0 + x, color);
-      drawPixel(x0 - x, y0 + y, color);
+
+    if (buf[x] < y) buf[x] = y;
+    if (buf[y] < x) buf[y] = x;
+  }
+  return buf;
+}
+
+// Fill the circle columns dx = first..r on the sides picked by cornername.
+// Neighbouring columns of the same height go out as one rectangle, and the
+// center run joins both sides, so each distinct height costs one window
+// per side.
+static void fillCircleSpans(int x0, int y0, int r, unsigned char cornername,
+                            int delta, int first, unsigned int color) {
+  unsigned char buf[WIDTH];
+  const unsigned char *spans = getCircleSpans(r, buf);
+  int a, b, h;
+
+  for (a = first; a <= r; a = b + 1) {
+    h = spans[a];
+    for (b = a; b < r && spans[b+1] == h; b++) ;
+
+    if (a == 0 && cornername == 3) {
+      fillRect(x0-b, y0-h, 2*b+1, 2*h+1+delta, color);
+      continue;
     }
     if (cornername & 0x1) {
-      drawPixel(x0 - y, y0 - x, color);
-      drawPixel(x0 - x, y0 - y, color);
+      fillRect(x0+a, y0-h, b-a+1, 2*h+1+delta, color);
+    }
+    if (cornername & 0x2) {
+      fillRect(x0-b, y0-h, b-a+1, 2*h+1+delta, color);
     }
   }
 }
 
 void fillCircle(int x0, int y0, int r,
 			      unsigned int color) {
+  if (clipRejects(x0 - r, y0 - r, x0 + r, y0 + r)) return;
+
+  if (r >= 0 && r < WIDTH) {
+    fillCircleSpans(x0, y0, r, 3, 0, 0, color);
+    return;
+  }
   drawFastVLine(x0, y0-r, 2*r+1, color);
   fillCircleHelper(x0, y0, r, 3, 0, color);
 }
@@ -144,6 +342,12 @@ void fillCircleHelper(int x0, int y0, int r,
   int x     = 0;
   int y     = r;
 
+  // the loop below only reaches the center column when r == 1
+  if (r >= 0 && r < WIDTH) {
+    fillCircleSpans(x0, y0, r, cornername, delta, r == 1 ? 0 : 1, color);
+    return;
+  }
+
   while (x<y) {
     if (f >= 0) {
       y--;
@@ -166,11 +370,19 @@ void fillCircleHelper(int x0, int y0, int r,
 }
 
 // Bresenham's algorithm - thx wikpedia
+//
+// Run-slice form: the pixels between two steps of the minor axis form a
+// straight run along the major axis. The length of each run comes straight
+// from the error term, and the run is drawn as one span.
 void drawLine(int x0, int y0, int x1, int y1, unsigned int color) {
   int steep;
   int dx, dy;
 	int err;
 	int ystep;
+  int run;
+
+  if (clipRejects((x0 < x1) ? x0 : x1, (y0 < y1) ? y0 : y1,
+                  (x0 < x1) ? x1 : x0, (y0 < y1) ? y1 : y0)) return;
 						
 	steep = abs(y1 - y0) > abs(x1 - x0);
   if (steep) {
@@ -194,13 +406,25 @@ void drawLine(int x0, int y0, int x1, int y1, unsigned int color) {
     ystep = -1;
   }
 
-  for (; x0<=x1; x0++) {
-    if (steep) {
-      drawPixel(y0, x0, color);
+  while (x0 <= x1) {
+    // pixels until err drops below zero, at most to the end of the line
+    run = (dy > 0) ? err / dy + 1 : x1 - x0 + 1;
+    if (run > x1 - x0 + 1) run = x1 - x0 + 1;
+
+    if (run == 1) {
+      if (steep) {
+        drawPixel(y0, x0, color);
+      } else {
+        drawPixel(x0, y0, color);
+      }
+    } else if (steep) {
+      fillRect(y0, x0, 1, run, color);
     } else {
-      drawPixel(x0, y0, color);
+      fillRect(x0, y0, run, 1, color);
     }
-    err -= dy;
+
+    x0 += run;
+    err -= run * dy;
     if (err < 0) {
       y0 += ystep;
       err += dx;
@@ -248,6 +472,9 @@ void fillScreen(unsigned int color) {
 // Draw a rounded rectangle
 void drawRoundRect(int x, int y, int w,
   int h, int r, unsigned int color) {
+#ifndef SSD1351_FRAMEBUFFER
+  startWrite();
+#endif
   // smarter version
   drawFastHLine(x+r  , y    , w-2*r, color); // Top
   drawFastHLine(x+r  , y+h-1, w-2*r, color); // Bottom
@@ -258,6 +485,9 @@ void drawRoundRect(int x, int y, int w,
   drawCircleHelper(x+w-r-1, y+r    , r, 2, color);
   drawCircleHelper(x+w-r-1, y+h-r-1, r, 4, color);
   drawCircleHelper(x+r    , y+h-r-1, r, 8, color);
+#ifndef SSD1351_FRAMEBUFFER
+  endWrite();
+#endif
 }
 
 // Fill a rounded rectangle
@@ -280,22 +510,58 @@ void drawTriangle(int x0, int y0,
   drawLine(x2, y2, x0, y0, color);
 }
 
+// Edge walker
+//
+// Steps along a polygon edge one scanline at a time. The x offset after k
+// rows is dx*k/dy rounded toward zero, kept as a whole part and a
+// remainder over dy, so each row costs two additions and no divide.
+
+typedef struct {
+  int x0, sign;
+  int dy;
+  int whole, frac;      // |dx| / dy and |dx| % dy
+  int q, rem;           // offset so far
+} EdgeWalk;
+
+// Edge from (x0, y0) to (x1, y1), y1 > y0, positioned k rows below y0
+static void edgeStart(EdgeWalk *e, int x0, int y0, int x1, int y1, int k) {
+  int adx = abs(x1 - x0);
+
+  e->x0 = x0;
+  e->sign = (x1 < x0) ? -1 : 1;
+  e->dy = y1 - y0;
+  e->whole = adx / e->dy;
+  e->frac = adx % e->dy;
+  e->q = e->whole * k + (e->frac * k) / e->dy;
+  e->rem = (e->frac * k) % e->dy;
+}
+
+static int edgeX(const EdgeWalk *e) {
+  return e->x0 + e->sign * e->q;
+}
+
+static void edgeNext(EdgeWalk *e) {
+  e->q += e->whole;
+  e->rem += e->frac;
+  if (e->rem >= e->dy) {
+    e->rem -= e->dy;
+    e->q++;
+  }
+}
+
+// One scanline of a filled shape, between two edge crossings
+static void fillRow(int a, int b, int y, unsigned int color) {
+  if (a > b) swap(a, b);
+  fillRect(a, y, b - a + 1, 1, color);
+}
+
 // Fill a triangle
 void fillTriangle ( int x0, int y0,
 				  int x1, int y1,
 				  int x2, int y2, unsigned int color) {
 
+  EdgeWalk e01, e02, e12;
   int a, b, y, last;
-  int
-    dx01 = x1 - x0,
-    dy01 = y1 - y0,
-    dx02 = x2 - x0,
-    dy02 = y2 - y0,
-    dx12 = x2 - x1,
-    dy12 = y2 - y1;
-  int
-    sa   = 0,
-    sb   = 0;						
 
   // Sort coordinates by Y order (y2 >= y1 >= y0)
   if (y0 > y1) {
@@ -308,93 +574,285 @@ void fillTriangle ( int x0, int y0,
     swap(y0, y1); swap(x0, x1);
   }
 
+  a = (x0 < x1) ? x0 : x1;
+  b = (x0 < x1) ? x1 : x0;
+  if (x2 < a) a = x2;
+  if (x2 > b) b = x2;
+  if (clipRejects(a, y0, b, y2)) return;
+
   if(y0 == y2) { // Handle awkward all-on-same-line case as its own thing
     a = b = x0;
     if(x1 < a)      a = x1;
     else if(x1 > b) b = x1;
     if(x2 < a)      a = x2;
     else if(x2 > b) b = x2;
-    drawFastHLine(a, y0, b-a+1, color);
+    fillRow(a, b, y0, color);
     return;
   }
 
+#ifndef SSD1351_FRAMEBUFFER
+  startWrite();
+#endif
 
-
-  // For upper part of triangle, find scanline crossings for segments
-  // 0-1 and 0-2.  If y1=y2 (flat-bottomed triangle), the scanline y1
-  // is included here (and second loop will be skipped, avoiding a /0
-  // error there), otherwise scanline y1 is skipped here and handled
-  // in the second loop...which also avoids a /0 error here if y0=y1
-  // (flat-topped triangle).
+  // For upper part of triangle, walk edges 0-1 and 0-2. If y1=y2
+  // (flat-bottomed triangle), the scanline y1 is included here, otherwise
+  // it is skipped here and handled in the second loop, which also keeps
+  // a flat-topped triangle (y0=y1) from walking a zero-height edge.
   if(y1 == y2) last = y1;   // Include y1 scanline
   else         last = y1-1; // Skip it
 
-  for(y=y0; y<=last; y++) {
-    a   = x0 + sa / dy01;
-    b   = x0 + sb / dy02;
-    sa += dx01;
-    sb += dx02;
-    /* longhand:
-    a = x0 + (x1 - x0) * (y - y0) / (y1 - y0);
-    b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
-    */
-    if(a > b) swap(a,b);
-    drawFastHLine(a, y, b-a+1, color);
-  }
-
-  // For lower part of triangle, find scanline crossings for segments
-  // 0-2 and 1-2.  This loop is skipped if y1=y2.
-  sa = dx12 * (y - y1);
-  sb = dx02 * (y - y0);
-  for(; y<=y2; y++) {
-    a   = x1 + sa / dy12;
-    b   = x0 + sb / dy02;
-    sa += dx12;
-    sb += dx02;
-    /* longhand:
-    a = x1 + (x2 - x1) * (y - y1) / (y2 - y1);
-    b = x0 + (x2 - x0) * (y - y0) / (y2 - y0);
-    */
-    if(a > b) swap(a,b);
-    drawFastHLine(a, y, b-a+1, color);
+  // rows above the clip rectangle are never walked: the edges start on
+  // the first visible row
+  y = (y0 > clipY0) ? y0 : clipY0;
+  edgeStart(&e02, x0, y0, x2, y2, y - y0);
+  if (y <= last) {
+    edgeStart(&e01, x0, y0, x1, y1, y - y0);
   }
+
+  for(; y<=last && y<clipY1; y++) {
+    fillRow(edgeX(&e01), edgeX(&e02), y, color);
+    edgeNext(&e01);
+    edgeNext(&e02);
+  }
+
+  // For lower part of triangle, walk edges 1-2 and 0-2. This loop is
+  // skipped if y1=y2.
+  if (y1 < y2 && y < clipY1) {
+    edgeStart(&e12, x1, y1, x2, y2, y - y1);
+    for(; y<=y2 && y<clipY1; y++) {
+      fillRow(edgeX(&e12), edgeX(&e02), y, color);
+      edgeNext(&e12);
+      edgeNext(&e02);
+    }
+  }
+
+#ifndef SSD1351_FRAMEBUFFER
+  endWrite();
+#endif
 }
-/*
-void drawBitmap(int x, int y,
-			      const unsigned char *bitmap, int w, int h,
-			      unsigned int color) {
 
-  int i, j, byteWidth = (w + 7) / 8;
+// Start the next edge of a polygon chain below vertex *i that reaches row
+// y, stepping by dir around the n vertices and skipping horizontal edges
+// and edges that end above y. The edge is positioned on row y. Returns 0
+// when the chain has reached the bottom.
+static int chainNext(EdgeWalk *e, const int *xs, const int *ys, int n,
+                     int *i, int dir, int y, int *endY) {
+  int j, steps;
 
-  for(j=0; j<h; j++) {
-    for(i=0; i<w; i++ ) {
-      if(pgm_read_byte(bitmap + j * byteWidth + i / 8) & (128 >> (i & 7))) {
-        drawPixel(x+i, y+j, color);
-      }
+  for (steps = 0; steps < n; steps++) {
+    j = (*i + dir + n) % n;
+    if (ys[j] < ys[*i]) return 0;
+    if (ys[j] >= y && ys[j] > ys[*i]) {
+      edgeStart(e, xs[*i], ys[*i], xs[j], ys[j], y - ys[*i]);
+      *endY = ys[j];
+      *i = j;
+      return 1;
     }
+    *i = j;
   }
+  return 0;
 }
-*/
-// Draw a 1-bit color bitmap at the specified x, y position from the
-// provided bitmap buffer (must be PROGMEM memory) using color as the
-// foreground color and bg as the background color.
-/*
-void drawBitmap(int x, int y,
-            const unsigned char *bitmap, int w, int h,
-            unsigned int color, unsigned int bg) {
 
-  int i, j, byteWidth = (w + 7) / 8;
-  
-  for(j=0; j<h; j++) {
-    for(i=0; i<w; i++ ) {
-      if(pgm_read_byte(bitmap + j * byteWidth + i / 8) & (128 >> (i & 7))) {
-        drawPixel(x+i, y+j, color);
-      }
-      else {
-      	drawPixel(x+i, y+j, bg);
+// Fill a convex polygon given its n vertices in order, either direction
+void fillPolygon(const int *xs, const int *ys, int n, unsigned int color) {
+  EdgeWalk left, right;
+  int li, ri, leftEnd, rightEnd;
+  int i, top = 0, bottom = 0, y, a, b;
+
+  if (n < 1) return;
+
+  a = b = xs[0];
+  for (i = 1; i < n; i++) {
+    if (ys[i] < ys[top]) top = i;
+    if (ys[i] > ys[bottom]) bottom = i;
+    if (xs[i] < a) a = xs[i];
+    if (xs[i] > b) b = xs[i];
+  }
+  if (clipRejects(a, ys[top], b, ys[bottom])) return;
+
+  // the chains start on the first visible row
+  y = (ys[top] > clipY0) ? ys[top] : clipY0;
+  li = ri = top;
+  if (!chainNext(&left, xs, ys, n, &li, -1, y, &leftEnd) ||
+      !chainNext(&right, xs, ys, n, &ri, 1, y, &rightEnd)) {
+    // no height: one span over every vertex
+    fillRow(a, b, ys[0], color);
+    return;
+  }
+
+#ifndef SSD1351_FRAMEBUFFER
+  startWrite();
+#endif
+  for (; y < clipY1; y++) {
+    fillRow(edgeX(&left), edgeX(&right), y, color);
+
+    // a chain that reaches its vertex continues along the next edge,
+    // which starts on this row
+    if (y == leftEnd && !chainNext(&left, xs, ys, n, &li, -1, y, &leftEnd)) break;
+    if (y == rightEnd && !chainNext(&right, xs, ys, n, &ri, 1, y, &rightEnd)) break;
+    edgeNext(&left);
+    edgeNext(&right);
+  }
+#ifndef SSD1351_FRAMEBUFFER
+  endWrite();
+#endif
+}
+
+// Integer square root, rounded down
+static long isqrt(long v) {
+  long r = 0, bit = 1L << 30;
+
+  while (bit > v) bit >>= 2;
+  while (bit) {
+    if (v >= r + bit) {
+      v -= r + bit;
+      r = (r >> 1) + bit;
+    } else {
+      r >>= 1;
+    }
+    bit >>= 2;
+  }
+  return r;
+}
+
+// num / den rounded to nearest, den > 0
+static int roundDiv(long num, long den) {
+  return (num >= 0) ? (num + den / 2) / den : -((-num + den / 2) / den);
+}
+
+// Draw a line width pixels thick with square ends, as a filled quad
+void drawThickLine(int x0, int y0, int x1, int y1, int width,
+                   unsigned int color) {
+  long dx = x1 - x0, dy = y1 - y0, len;
+  int nx, ny, xs[4], ys[4];
+
+  if (width <= 1) {
+    drawLine(x0, y0, x1, y1, color);
+    return;
+  }
+
+  len = isqrt(dx * dx + dy * dy);
+  if (len == 0) {
+    fillRect(x0 - (width - 1) / 2, y0 - (width - 1) / 2, width, width, color);
+    return;
+  }
+
+  // normal to the line, width-1 pixels long, split across both sides
+  nx = roundDiv(-dy * (width - 1), len);
+  ny = roundDiv(dx * (width - 1), len);
+
+  xs[0] = x0 + nx / 2;        ys[0] = y0 + ny / 2;
+  xs[1] = x1 + nx / 2;        ys[1] = y1 + ny / 2;
+  xs[2] = x1 - (nx - nx / 2); ys[2] = y1 - (ny - ny / 2);
+  xs[3] = x0 - (nx - nx / 2); ys[3] = y0 - (ny - ny / 2);
+  fillPolygon(xs, ys, 4, color);
+}
+
+// 1-bit bitmaps
+//
+// Each row is (w + 7) / 8 bytes. Adafruit bitmaps keep the leftmost pixel
+// of a byte in bit 7, XBM files keep it in bit 0. Opaque bitmaps are
+// expanded a row at a time and streamed into one window; transparent ones
+// are drawn as one span per run of set pixels. The band list only keeps
+// pointers to RGB565 images, so banded builds draw opaque bitmaps as runs
+// of both colors instead.
+
+#ifndef SSD1351_BANDED
+// Expand pixels i0..i1-1 of one bitmap row into out
+static void bitmapExpand(const unsigned char *row, int i0, int i1, char xbm,
+                         unsigned int color, unsigned int bg,
+                         unsigned short *out) {
+  const unsigned char *p = row + (i0 >> 3);
+  unsigned char mask = xbm ? (0x01 << (i0 & 7)) : (0x80 >> (i0 & 7));
+  int i;
+
+  for (i = i0; i < i1; i++) {
+    *out++ = (*p & mask) ? color : bg;
+    mask = xbm ? (mask << 1) : (mask >> 1);
+    if (!mask) {
+      mask = xbm ? 0x01 : 0x80;
+      p++;
+    }
+  }
+}
+#endif
+
+static int bitmapBit(const unsigned char *row, int i, char xbm) {
+  return xbm ? (row[i >> 3] >> (i & 7)) & 0x1
+             : (row[i >> 3] >> (7 - (i & 7))) & 0x1;
+}
+
+static void drawBitmap1(int x, int y, const unsigned char *bitmap,
+                        int w, int h, unsigned int color, unsigned int bg,
+                        char opaque, char xbm) {
+  int byteWidth = (w + 7) / 8;
+  int i0 = 0, i1 = w, j0 = 0, j1 = h;
+  int i, j, start, bit;
+  const unsigned char *row;
+#ifndef SSD1351_BANDED
+  unsigned short line[WIDTH];
+#endif
+
+  // clip in bitmap coordinates
+  if (x < clipX0) i0 = clipX0 - x;
+  if (y < clipY0) j0 = clipY0 - y;
+  if (x + w > clipX1) i1 = clipX1 - x;
+  if (y + h > clipY1) j1 = clipY1 - y;
+  if (i0 >= i1 || j0 >= j1) return;
+
+  if (opaque && bg == color) {
+    fillRect(x + i0, y + j0, i1 - i0, j1 - j0, color);
+    return;
+  }
+
+#ifndef SSD1351_FRAMEBUFFER
+  startWrite();
+#endif
+#ifndef SSD1351_BANDED
+  if (opaque) {
+#ifndef SSD1351_FRAMEBUFFER
+    setWindow(x + i0, y + j0, x + i1 - 1, y + j1 - 1);
+#endif
+    for (j = j0; j < j1; j++) {
+      bitmapExpand(bitmap + j * byteWidth, i0, i1, xbm, color, bg, line);
+#ifdef SSD1351_FRAMEBUFFER
+      fbDrawBitmap(x + i0, y + j, line, i1 - i0, 1, i1 - i0);
+#else
+      sendPixels(line, i1 - i0);
+#endif
+    }
+  } else
+#endif
+  {
+    for (j = j0; j < j1; j++) {
+      row = bitmap + j * byteWidth;
+      for (i = i0; i < i1; ) {
+        bit = bitmapBit(row, i, xbm);
+        start = i;
+        while (i < i1 && bitmapBit(row, i, xbm) == bit) i++;
+        if (bit) fillRect(x + start, y + j, i - start, 1, color);
+        else if (opaque) fillRect(x + start, y + j, i - start, 1, bg);
       }
     }
   }
+#ifndef SSD1351_FRAMEBUFFER
+  endWrite();
+#endif
+}
+
+// Draw a 1-bit bitmap, set bits in color and clear bits left untouched
+void drawBitmap(int x, int y,
+			      const unsigned char *bitmap, int w, int h,
+			      unsigned int color) {
+  drawBitmap1(x, y, bitmap, w, h, color, color, 0, 0);
+}
+
+// Draw a 1-bit bitmap using color as the foreground color and bg as the
+// background color
+void drawBitmapBg(int x, int y,
+            const unsigned char *bitmap, int w, int h,
+            unsigned int color, unsigned int bg) {
+  drawBitmap1(x, y, bitmap, w, h, color, bg, 1, 0);
 }
 
 //Draw XBitMap Files (*.xbm), exported from GIMP,
@@ -403,16 +861,7 @@ void drawBitmap(int x, int y,
 void drawXBitmap(int x, int y,
                               const unsigned char *bitmap, int w, int h,
                               unsigned int color) {
-  
-  int i, j, byteWidth = (w + 7) / 8;
-  
-  for(j=0; j<h; j++) {
-    for(i=0; i<w; i++ ) {
-      if(pgm_read_byte(bitmap + j * byteWidth + i / 8) & (1 << (i % 8))) {
-        drawPixel(x+i, y+j, color);
-      }
-    }
-  }
+  drawBitmap1(x, y, bitmap, w, h, color, color, 0, 1);
 }
 
 #if ARDUINO >= 100
@@ -437,52 +886,209 @@ void write(unsigned char c) {
   return 1;
 #endif
 }
-*/
+
+// Opaque glyphs: expand each of the 8 glyph rows once, scaled across, and
+// send it size times into a single window covering the visible part. cols
+// holds 6 columns for each of the n glyphs.
+static void drawGlyphWindow(int x, int y, const unsigned char *cols, int n,
+                            unsigned int color, unsigned int bg,
+                            unsigned char size) {
+  unsigned short row[WIDTH];
+  int x0 = x, y0 = y, x1 = x + 6*n*size - 1, y1 = y + 8*size - 1;
+  int gi, rep, px, r, top, bottom, w;
+  char j;
+
+  if (x0 < clipX0) x0 = clipX0;
+  if (y0 < clipY0) y0 = clipY0;
+  if (x1 > clipX1 - 1) x1 = clipX1 - 1;
+  if (y1 > clipY1 - 1) y1 = clipY1 - 1;
+  w = x1 - x0 + 1;
+
+#ifndef SSD1351_FRAMEBUFFER
+  startWrite();
+  setWindow(x0, y0, x1, y1);
+#endif
+  for (j = 0; j < 8; j++) {
+    top = y + j*size;
+    bottom = top + size - 1;
+    if (top < y0) top = y0;
+    if (bottom > y1) bottom = y1;
+    if (top > bottom) continue;
+
+    gi = (x0 - x) / size;
+    rep = (x0 - x) % size;
+    for (px = 0; px < w; px++) {
+      row[px] = ((cols[gi] >> j) & 0x1) ? color : bg;
+      if (++rep == size) {
+        rep = 0;
+        gi++;
+      }
+    }
+
+    for (r = top; r <= bottom; r++) {
+#ifdef SSD1351_FRAMEBUFFER
+      fbDrawBitmap(x0, r, row, w, 1, w);
+#else
+      sendPixels(row, w);
+#endif
+    }
+  }
+#ifndef SSD1351_FRAMEBUFFER
+  endWrite();
+#endif
+}
+
 // Draw a character
 void drawChar(int x, int y, unsigned char c,
 			    unsigned int color, unsigned int bg, unsigned char size) {
 
-  unsigned char line;	
-  char i;						
-  char j;						
-						
-  if((x >= WIDTH)            || // Clip right
-     (y >= HEIGHT)           || // Clip bottom
-     ((x + 6 * size - 1) < 0) || // Clip left
-     ((y + 8 * size - 1) < 0))   // Clip top
-    return;
+  unsigned char cols[6];
+  unsigned char line, run, edges;
+  char i, j, top, w;
+#if defined SSD1351_BANDED || defined SSD1351_GLYPH_CACHE
+  int inside;
+#endif
+
+  if (clipRejects(x, y, x + 6*size - 1, y + 8*size - 1)) return;
+
+#if defined SSD1351_BANDED || defined SSD1351_GLYPH_CACHE
+  // only glyphs wholly inside the clip rectangle take the shortcuts
+  inside = clipContains(x, y) &&
+           clipContains(x + 6*size - 1, y + 8*size - 1);
+#endif
+
+#ifdef SSD1351_BANDED
+  if (inside && bandDrawChar(x, y, c, color, bg, size)) return;
+#endif
 
-  for (i=0; i<6; i++ ) {
-    if (i == 5) 
-      line = 0x0;
-    else 
-      line = font[(c*5)+i];
+  for (i=0; i<5; i++) {
+    cols[i] = font[(c*5)+i];
+  }
+  cols[5] = 0x0;
+
+  if (bg != color) {
+#ifdef SSD1351_GLYPH_CACHE
+    if (inside) {
+      const unsigned short *pixels = glyphCacheGet(c, color, bg, size);
+
+      if (pixels) {
+        drawRGBBitmap(x, y, pixels, 6*size, 8*size);
+        return;
+      }
+    }
+#endif
+#ifdef SSD1351_BANDED
+    // the display list only takes whole glyphs, so a clipped one is drawn
+    // as its background box and then its set pixels
+    if (!inside) {
+      fillRect(x, y, 6*size, 8*size, bg);
+    } else
+#endif
+    {
+      drawGlyphWindow(x, y, cols, 1, color, bg, size);
+      return;
+    }
+  }
+
+  // set pixels: one rectangle per vertical run, widened over the columns
+  // to its right that have exactly the same run, all in one transaction
+  // (banded builds only record them)
+#if !defined SSD1351_FRAMEBUFFER && !defined SSD1351_BANDED
+  startWrite();
+#endif
+  for (i=0; i<5; i++) {
+    line = cols[i];
     for (j = 0; j<8; j++) {
-      if (line & 0x1) {
-        if (size == 1) // default size
-          drawPixel(x+i, y+j, color);
-        else {  // big size
-          fillRect(x+(i*size), y+(j*size), size, size, color);
-        } 
-      } else if (bg != color) {
-        if (size == 1) // default size
-          drawPixel(x+i, y+j, bg);
-        else {  // big size
-          fillRect(x+i*size, y+j*size, size, size, bg);
+      if (!((line >> j) & 0x1)) continue;
+      top = j;
+      while (j < 7 && ((line >> (j+1)) & 0x1)) j++;
+
+      run = (unsigned char)((0xFF >> (7 - j)) & (0xFF << top));
+      edges = (unsigned char)(run | (run << 1) | (run >> 1));
+      for (w = 1; i + w < 5 && (cols[i+w] & edges) == run; w++) {
+        cols[i+w] &= ~run;
+      }
+      fillRect(x+i*size, y+top*size, w*size, (j-top+1)*size, color);
+    }
+  }
+#if !defined SSD1351_FRAMEBUFFER && !defined SSD1351_BANDED
+  endWrite();
+#endif
+}
+
+// Draw n glyphs side by side. Opaque ones go out as one window per screen
+// width of glyphs rather than one per character.
+void drawGlyphRun(int x, int y, const unsigned char *glyphs, int n,
+                  unsigned int color, unsigned int bg, unsigned char size) {
+  int i;
+
+#ifndef SSD1351_BANDED
+  if (bg != color) {
+    unsigned char cols[WIDTH];
+    int k, run;
+
+    for (; n > 0; n -= run, glyphs += run, x += 6*run*size) {
+      run = (n < WIDTH/6) ? n : WIDTH/6;
+      if (clipRejects(x, y, x + 6*run*size - 1, y + 8*size - 1)) continue;
+
+      for (i = 0; i < run; i++) {
+        for (k = 0; k < 5; k++) {
+          cols[6*i + k] = font[glyphs[i]*5 + k];
         }
+        cols[6*i + 5] = 0x0;
       }
-      line >>= 1;
+      drawGlyphWindow(x, y, cols, run, color, bg, size);
     }
+    return;
+  }
+#endif
+  // the display list takes whole glyphs, and transparent ones are runs
+  for (i = 0; i < n; i++) {
+    drawChar(x + 6*i*size, y, glyphs[i], color, bg, size);
   }
 }
 
+// Column bitmaps (5 bytes, LSB at the top) for character c
+const unsigned char *getGlyph(unsigned char c) {
+  return &font[c * 5];
+}
+
+// UTF-8 text at the cursor. With wrap set, lines break between words at
+// the right edge and continue at the left; '\n' always starts a new line.
 void Outstr (char * str) {
-	char * ptr;
-	
-	ptr = str;
-	while (*ptr) {
-		drawChar(cursor_x, cursor_y, *ptr++, textcolor, textbgcolor, textsize);
-		cursor_x += 6*textsize;
+	const char *s = str, *line;
+	unsigned char glyphs[WIDTH/6];
+	int cell = 6*textsize;
+	int cols = (_width / cell > 0) ? _width / cell : 1;
+	int used, n, next, count;
+
+	while (*s) {
+		if (wrap) {
+			used = cols - (_width - cursor_x) / cell;
+			n = textBreak(s, (used > 0) ? used : 0, cols, &next);
+		} else {
+			n = 0;
+			while (s[n] && s[n] != '\n') n++;
+			next = s[n] ? n + 1 : n;
+		}
+
+		// one run per screen width of glyphs
+		line = s;
+		while (line < s + n) {
+			count = 0;
+			while (line < s + n && count < WIDTH/6) {
+				glyphs[count++] = textGlyph(&line);
+			}
+			drawGlyphRun(cursor_x, cursor_y, glyphs, count, textcolor,
+			             textbgcolor, textsize);
+			cursor_x += count*cell;
+		}
+
+		s += next;
+		if (next > n || *s) {
+			cursor_x = 0;
+			cursor_y += 8*textsize;
+		}
 	}
 }
 
@@ -491,6 +1097,14 @@ void setCursor(int x, int y) {
   cursor_y = y;
 }
 
+int getCursorX(void) {
+  return cursor_x;
+}
+
+int getCursorY(void) {
+  return cursor_y;
+}
+
 void setTextSize(unsigned char s) {
   textsize = (s > 0) ? s : 1;
 }
@@ -511,14 +1125,17 @@ void setTextColor(unsigned int c, unsigned int b) {
 void setTextWrap(char w) {
   wrap = w;
 }
-/*
+
 unsigned char getRotation(void) {
   return rotation;
 }
 
 
+// The controller turns the image itself (see setDisplayRotation()), so
+// rotation only changes the size everything is clipped to
 void setRotation(unsigned char x) {
-  rotation = (x & 3);
+  setDisplayRotation(x & 3);
+  rotation = getDisplayRotation();
   switch(rotation) {
    case 0:
    case 2:
@@ -531,18 +1148,16 @@ void setRotation(unsigned char x) {
     _height = WIDTH;
     break;
   }
+  clearClipRect();
 }
 
-*/
 // Return the size of the display (per current rotation)
 int width(void) {
-//  return _width;
-	return WIDTH;
+  return _width;
 }
  
 int height(void) {
-//  return _height;
-	return HEIGHT;
+  return _height;
 }
 
 
@@ -42,20 +42,34 @@
     void drawCircleHelper(int x0, int y0, int r, unsigned char cornername, unsigned int color);
     void fillCircle(int x0, int y0, int r, unsigned int color);
     void fillCircleHelper(int x0, int y0, int r, unsigned char cornername, int delta, unsigned int color);
+    const unsigned char *getCircleSpans(int r, unsigned char *buf);
     void drawTriangle(int x0, int y0, int x1, int y1, int x2, int y2, unsigned int color);
     void fillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, unsigned int color);
+    void fillPolygon(const int *xs, const int *ys, int n, unsigned int color);
+    void drawThickLine(int x0, int y0, int x1, int y1, int width, unsigned int color);
     void drawRoundRect(int x0, int y0, int w, int h, int radius, unsigned int color);
     void fillRoundRect(int x0, int y0, int w, int h, int radius, unsigned int color);
     void drawBitmap(int x, int y, const unsigned char *bitmap, int w, int h, unsigned int color);
-//    void drawBitmap(int x, int y, const unsigned char *bitmap, int w, int h, unsigned int color, unsigned int bg);
+    void drawBitmapBg(int x, int y, const unsigned char *bitmap, int w, int h, unsigned int color, unsigned int bg);
     void drawXBitmap(int x, int y, const unsigned char *bitmap, int w, int h, unsigned int color);
     void drawChar(int x, int y, unsigned char c, unsigned int color, unsigned int bg, unsigned char size);
+    void drawGlyphRun(int x, int y, const unsigned char *glyphs, int n, unsigned int color, unsigned int bg, unsigned char size);
+    const unsigned char *getGlyph(unsigned char c);
     void setCursor(int x, int y);
+    int getCursorX(void);
+    int getCursorY(void);
 //    void setTextColor(unsigned int c);
     void setTextColor(unsigned int c, unsigned int bg);
     void setTextSize(unsigned char s);
     void setTextWrap(char w);
-//    void setRotation(unsigned char r);
+    void setRotation(unsigned char r);
+
+  // Clip rectangle honored by every primitive; covers the screen by default
+    void setClipRect(int x, int y, int w, int h);
+    void clearClipRect(void);
+    void getClipRect(int *x, int *y, int *w, int *h);
+    int clipRect(int *x, int *y, int *w, int *h);
+    int clipContains(int x, int y);
 
 #if ARDUINO >= 100
   virtual size_t write(unsigned char);
@@ -6,6 +6,7 @@
 #include "hw_memmap.h"
 #include "hw_common_reg.h"
 #include "hw_ints.h"
+#include "hw_mcspi.h"
 #include "gpio.h"
 #include "spi.h"
 #include "rom.h"
@@ -14,12 +15,17 @@
 #include "prcm.h"
 #include "uart.h"
 #include "interrupt.h"
+#include "timer.h"
 
 // Common interface includes
 #include "uart_if.h"
+#include "timer_if.h"
 #include "pin_mux_config.h"
 
 #include "Adafruit_SSD1351.h"
+#include "Adafruit_GFX.h"
+#include "oled_framebuffer.h"
+#include "oled_band.h"
 
 
 #define OLED_CS_BASE  GPIOA2_BASE  // PIN_15
@@ -31,177 +37,807 @@
 #define OLED_RESET_BASE  GPIOA3_BASE  // PIN_45
 #define OLED_RESET_PIN   0x80
 
+// One-shot for the reset timing; main.c runs on SysTick and the benchmarks
+// use TIMERA2
+#define OLED_DELAY_TIMER_PRCM  PRCM_TIMERA3
+#define OLED_DELAY_TIMER_BASE  TIMERA3_BASE
 
+
+//*****************************************************************************
+// Transaction-level SPI interface
+//
+// A transaction holds CS low across any number of command/data bytes, and the
+// DC line is only written when the byte type actually changes. Transactions
+// nest, so a primitive can wrap several lower-level writes in one CS cycle.
 //*****************************************************************************
 
-void writeCommand(unsigned char c) {
+static unsigned int txnDepth = 0;
+static int dcState = -1;    // -1 = unknown, 0 = command, 1 = data
+static int linkMode = SSD1351_LINK_BYTE;
 
-//TODO 1
-/* Write a function to send a command byte c to the OLED via
-*  SPI.
-*/
+// Set while an asynchronous (DMA) transfer owns the bus
+volatile unsigned char displayBusy = 0;
+
+unsigned long displayBytes = 0;
+
+static void spiPut(unsigned char c) {
         unsigned long ulDummy;
 
+#ifdef SSD1351_3WIRE
+        MAP_SPIDataPut(GSPI_BASE, ((unsigned long)dcState << 8) | c);
+#else
+        MAP_SPIDataPut(GSPI_BASE, c);
+#endif
+        displayBytes++;
+
+        // clear RX register (nothing is received in the word-packed modes)
+        if (linkMode == SSD1351_LINK_BYTE) {
+                MAP_SPIDataGet(GSPI_BASE, &ulDummy);
+        }
+}
+
+// In the transmit-only modes a write returns as soon as the word is queued,
+// so wait for the FIFO and shift register to empty before DC or CS change.
+// EOT only covers the word in the shift register; with the TX FIFO enabled
+// it can be set between two words while more are still queued.
+static void spiDrain(void) {
+        if (linkMode == SSD1351_LINK_BYTE) return;
+
+        while (!(HWREG(GSPI_BASE + MCSPI_O_CH0STAT) & MCSPI_CH0STAT_TXFFE));
+        while (!(HWREG(GSPI_BASE + MCSPI_O_CH0STAT) & MCSPI_CH0STAT_EOT));
+}
+
+// In 3-wire mode D/C only selects the 9th bit of the following words
+static void setDC(int dc) {
+        if (dcState == dc) return;
+
+#ifndef SSD1351_3WIRE
+        spiDrain();
+        GPIOPinWrite(OLED_DC_BASE, OLED_DC_PIN, dc ? OLED_DC_PIN : 0);
+#endif
+        dcState = dc;
+}
+
+// A DMA transfer (oled_dma.c) opens its transaction before setting
+// displayBusy and closes it from its completion interrupt, so txnDepth can
+// be above zero while the bus belongs to the transfer. Every startWrite()
+// therefore waits for the transfer, at any depth, and txnDepth only changes
+// with interrupts masked.
+void startWrite(void) {
+        tBoolean masked;
+        unsigned int depth;
+
+        for (;;) {
+                while (displayBusy);
+
+                // the transfer may have been started from an interrupt
+                // between the wait and the mask
+                masked = MAP_IntMasterDisable();
+                if (!displayBusy) break;
+                if (!masked) MAP_IntMasterEnable();
+        }
+        depth = txnDepth++;
+        if (!masked) MAP_IntMasterEnable();
+
+        if (depth > 0) return;
+
         // CS low (pin 15)
         MAP_SPICSEnable(GSPI_BASE);
         GPIOPinWrite(OLED_CS_BASE, OLED_CS_PIN, 0);
+}
 
-        // DC low = command (pin 61)
-        GPIOPinWrite(OLED_DC_BASE, OLED_DC_PIN, 0);
+void endWrite(void) {
+        tBoolean masked;
+        unsigned int depth;
 
-        // send command byte
-        MAP_SPIDataPut(GSPI_BASE, c);
+        masked = MAP_IntMasterDisable();
+        depth = txnDepth;
+        if (depth > 0) txnDepth = depth - 1;
+        if (!masked) MAP_IntMasterEnable();
 
-        // clear RX register
-        MAP_SPIDataGet(GSPI_BASE, &ulDummy);
+        if (depth != 1) return;
 
         // CS high
+        spiDrain();
         MAP_SPICSDisable(GSPI_BASE);
         GPIOPinWrite(OLED_CS_BASE, OLED_CS_PIN, OLED_CS_PIN);
+}
+
+//*****************************************************************************
+// Address window shadow
+//
+// The driver remembers the column/row window last sent to the controller and
+// follows its RAM write pointer as pixel data goes out. setWindow() then
+// only resends the half of the window that changed, and nothing at all when
+// the pointer already sits where the next write starts.
+//*****************************************************************************
 
+static unsigned char winValid = 0;   // shadow matches the controller
+static unsigned char ramWrite = 0;   // WRITERAM active, data goes to RAM
+static unsigned char halfPixel = 0;  // first byte of a pixel already sent
+static unsigned char winX0, winY0, winX1, winY1;
+static unsigned char ptrX, ptrY;
+
+// rotation programmed by setDisplayRotation(); odd values swap the address
+// commands
+static unsigned char displayRotation = 0;
+
+// address command bytes that did not need to be sent
+unsigned long displayElidedBytes = 0;
+
+// Move the shadow pointer the way the controller does with horizontal
+// address increment: along the row, then wrapping inside the window
+static void advancePointer(unsigned long pixels) {
+        unsigned long w, h, i;
+
+        if (!winValid) return;
+
+        if (pixels == 1) {
+                if (++ptrX > winX1) {
+                        ptrX = winX0;
+                        if (++ptrY > winY1) ptrY = winY0;
+                }
+                return;
+        }
+
+        w = winX1 - winX0 + 1;
+        h = winY1 - winY0 + 1;
+        i = ((ptrY - winY0) * w + (ptrX - winX0) + pixels) % (w * h);
+        ptrX = winX0 + i % w;
+        ptrY = winY0 + i / w;
 }
+
+// Account for pixels streamed by sendColor()/sendPixels() or a DMA transfer
+void advanceWindow(unsigned long pixels) {
+        if (!ramWrite) return;
+
+        // a stream that starts mid-pixel is not worth following
+        if (halfPixel) {
+                winValid = 0;
+                return;
+        }
+        advancePointer(pixels);
+}
+
+static void splitAdvance(unsigned long pixels);
+
+// Send a command byte inside an open transaction (DC low)
+void sendCommand(unsigned char c) {
+        // a command ends RAM writing; addressing commands sent from outside
+        // setWindow() leave the shadow unknown
+        ramWrite = 0;
+        if (c == SSD1351_CMD_SETCOLUMN || c == SSD1351_CMD_SETROW ||
+            c == SSD1351_CMD_WRITERAM || c == SSD1351_CMD_SETREMAP) {
+                winValid = 0;
+        }
+
+        setDC(0);
+        spiPut(c);
+}
+
+// Send a data byte inside an open transaction (DC high)
+void sendData(unsigned char c) {
+        setDC(1);
+        spiPut(c);
+
+        if (ramWrite) {
+                halfPixel ^= 1;
+                if (!halfPixel) {
+                        advancePointer(1);
+                        splitAdvance(1);
+                }
+        }
+}
+
+//*****************************************************************************
+// Word-packed pixel link
+//
+// In SSD1351_LINK_WORD16/32 the channel runs transmit-only with the TX FIFO
+// enabled, so no RX word has to be read back after each write.
+// Commands still go out as 8-bit words; pixel streams switch the word
+// length to 16 or 32 bits for their duration and pack one or two pixels
+// per SPI word. Short streams are not worth the reconfiguration.
 //*****************************************************************************
 
-void writeData(unsigned char c) {
+// CH0CONF.TRM = 2: transmit only, nothing is clocked into RX
+#define MCSPI_TRM_TX_ONLY  (2 << MCSPI_CH0CONF_TRM_S)
 
-//TODO 2
-/* Write a function to send a data byte c to the OLED via
-*  SPI.
-*/
-        unsigned long ulDummy;
+#define LINK_MIN_PIXELS  8
 
-        // CS low (pin 15)
-        MAP_SPICSEnable(GSPI_BASE);
-        GPIOPinWrite(OLED_CS_BASE, OLED_CS_PIN, 0);
+// word length for single command/data bytes
+#ifdef SSD1351_3WIRE
+#define LINK_WL_BYTE  SSD1351_WL_9
+#else
+#define LINK_WL_BYTE  SPI_WL_8
+#endif
 
-        // DC high = data (pin 61)
-        GPIOPinWrite(OLED_DC_BASE, OLED_DC_PIN, OLED_DC_PIN);
+// Word length and TRM can only be changed while the channel is disabled
+static void spiSetConf(unsigned long conf) {
+        MAP_SPIDisable(GSPI_BASE);
+        HWREG(GSPI_BASE + MCSPI_O_CH0CONF) = conf;
+        MAP_SPIEnable(GSPI_BASE);
+}
 
-        // send data byte
-        MAP_SPIDataPut(GSPI_BASE, c);
+static void spiSetWordLength(unsigned long wl) {
+        unsigned long conf = HWREG(GSPI_BASE + MCSPI_O_CH0CONF);
 
-        // clear RX register
-        MAP_SPIDataGet(GSPI_BASE, &ulDummy);
+        spiSetConf((conf & ~MCSPI_CH0CONF_WL_M) | wl);
+}
 
-        // CS high
-        MAP_SPICSDisable(GSPI_BASE);
-        GPIOPinWrite(OLED_CS_BASE, OLED_CS_PIN, OLED_CS_PIN);
+void setLinkMode(int mode) {
+        unsigned long conf;
+
+        while (displayBusy);
+
+        conf = HWREG(GSPI_BASE + MCSPI_O_CH0CONF);
+        conf &= ~(MCSPI_CH0CONF_WL_M | MCSPI_CH0CONF_TRM_M |
+                  MCSPI_CH0CONF_TURBO | MCSPI_CH0CONF_FFEW);
+        conf |= LINK_WL_BYTE;
+
+        if (mode != SSD1351_LINK_WORD16 && mode != SSD1351_LINK_WORD32) {
+                mode = SSD1351_LINK_BYTE;
+        } else {
+                conf |= MCSPI_TRM_TX_ONLY | MCSPI_CH0CONF_FFEW;
+        }
+
+        spiDrain();
+        spiSetConf(conf);
+        linkMode = mode;
+}
+
+int getLinkMode(void) {
+        return linkMode;
+}
+
+// Reconfigure the GSPI clock with the same settings as SPIInit() in main.c
+void setLinkBitRate(unsigned long rate) {
+        if (rate > SSD1351_MAX_BIT_RATE) rate = SSD1351_MAX_BIT_RATE;
+
+        while (displayBusy);
+        spiDrain();
+
+        MAP_SPIDisable(GSPI_BASE);
+        MAP_SPIConfigSetExpClk(GSPI_BASE, MAP_PRCMPeripheralClockGet(PRCM_GSPI),
+                        rate, SPI_MODE_MASTER, SPI_SUB_MODE_0,
+                        (SPI_SW_CTRL_CS |
+                        SPI_4PIN_MODE |
+                        SPI_TURBO_OFF |
+                        SPI_CS_ACTIVEHIGH |
+                        SPI_WL_8));
+        MAP_SPIEnable(GSPI_BASE);
+
+        setLinkMode(linkMode);
+}
+
+static int linkWords(unsigned long count) {
+        return linkMode != SSD1351_LINK_BYTE && count >= LINK_MIN_PIXELS;
 }
 
 //*****************************************************************************
-void Adafruit_Init(void){
 
-//TODO 3
-/* NOTE: This function assumes that the RESET pin of the 
-*  OLED has been wired to GPIO28, pin 18 (P2.2). If you 
-*  use a different pin for the OLED reset, then you should
-*  update the GPIOPinWrite commands below that set RESET 
-*  high or low.
-*/
+static void sendColorRun(unsigned int color, unsigned long count) {
+        unsigned char hi = color >> 8;
+        unsigned char lo = color;
+
+        setDC(1);
+        advanceWindow(count);
+
+        if (linkWords(count)) {
+                spiDrain();
+#ifdef SSD1351_3WIRE
+                // two 9-bit bytes per 18-bit word; a pair would not fit in 32
+                spiSetWordLength(SSD1351_WL_18);
+                displayBytes += 2 * count;
+                for (; count > 0; count--) {
+                        MAP_SPIDataPut(GSPI_BASE, SSD1351_PIXEL_WORD(color));
+                }
+#else
+                if (linkMode == SSD1351_LINK_WORD32) {
+                        unsigned long pair = ((unsigned long)(color & 0xFFFF) << 16) | (color & 0xFFFF);
+
+                        spiSetWordLength(SPI_WL_32);
+                        displayBytes += 4 * (count / 2);
+                        for (; count >= 2; count -= 2) {
+                                MAP_SPIDataPut(GSPI_BASE, pair);
+                        }
+                } else {
+                        spiSetWordLength(SPI_WL_16);
+                        displayBytes += 2 * count;
+                        for (; count > 0; count--) {
+                                MAP_SPIDataPut(GSPI_BASE, color & 0xFFFF);
+                        }
+                }
+#endif
+                spiDrain();
+                spiSetWordLength(LINK_WL_BYTE);
+        }
+
+        // byte link, or the odd pixel left over in 32-bit mode
+        while (count--) {
+                spiPut(hi);
+                spiPut(lo);
+        }
+}
 
-  volatile unsigned long delay;
+static void sendPixelRun(const unsigned short *pixels, unsigned long count) {
+        setDC(1);
+        advanceWindow(count);
+
+        if (linkWords(count)) {
+                spiDrain();
+#ifdef SSD1351_3WIRE
+                spiSetWordLength(SSD1351_WL_18);
+                displayBytes += 2 * count;
+                for (; count > 0; count--) {
+                        MAP_SPIDataPut(GSPI_BASE, SSD1351_PIXEL_WORD(*pixels));
+                        pixels++;
+                }
+#else
+                if (linkMode == SSD1351_LINK_WORD32) {
+                        spiSetWordLength(SPI_WL_32);
+                        displayBytes += 4 * (count / 2);
+                        for (; count >= 2; count -= 2) {
+                                MAP_SPIDataPut(GSPI_BASE, ((unsigned long)pixels[0] << 16) | pixels[1]);
+                                pixels += 2;
+                        }
+                } else {
+                        spiSetWordLength(SPI_WL_16);
+                        displayBytes += 2 * count;
+                        for (; count > 0; count--) {
+                                MAP_SPIDataPut(GSPI_BASE, *pixels++);
+                        }
+                }
+#endif
+                spiDrain();
+                spiSetWordLength(LINK_WL_BYTE);
+        }
+
+        while (count--) {
+                spiPut(*pixels >> 8);
+                spiPut(*pixels++);
+        }
+}
 
+static void sendWindowCommand(unsigned char c) {
+        setDC(0);
+        spiPut(c);
+}
 
-  // RESET low (pin 45)
+// Set a window in display RAM coordinates, skipping the parts the
+// controller already has. In odd rotations the x range goes out as rows
+// and the y range as columns.
+static void setRamWindow(unsigned char x0, unsigned char y0,
+                         unsigned char x1, unsigned char y1) {
+        unsigned char xCmd = SSD1351_CMD_SETCOLUMN, yCmd = SSD1351_CMD_SETROW;
+        int sent = 0;
+
+        if (halfPixel) {
+                winValid = 0;
+                halfPixel = 0;
+        }
+
+        if (displayRotation & 1) {
+                xCmd = SSD1351_CMD_SETROW;
+                yCmd = SSD1351_CMD_SETCOLUMN;
+        }
+
+        // each range command also moves the pointer back to its start
+        if (!winValid || winX0 != x0 || winX1 != x1 || ptrX != x0) {
+                ramWrite = 0;
+                sendWindowCommand(xCmd);
+                sendData(x0);
+                sendData(x1);
+                sent = 1;
+        } else {
+                displayElidedBytes += 3;
+        }
+
+        if (!winValid || winY0 != y0 || winY1 != y1 || ptrY != y0) {
+                ramWrite = 0;
+                sendWindowCommand(yCmd);
+                sendData(y0);
+                sendData(y1);
+                sent = 1;
+        } else {
+                displayElidedBytes += 3;
+        }
+
+        if (sent || !ramWrite) {
+                sendWindowCommand(SSD1351_CMD_WRITERAM);
+        } else {
+                displayElidedBytes += 1;
+        }
+
+        winX0 = x0;
+        winY0 = y0;
+        winX1 = x1;
+        winY1 = y1;
+        ptrX = x0;
+        ptrY = y0;
+        // an inverted (empty) window is not followed
+        winValid = (x0 <= x1) && (y0 <= y1);
+        ramWrite = 1;
+        setDC(1);
+}
 
-  GPIOPinWrite(OLED_RESET_BASE, OLED_RESET_PIN, 0);
+//*****************************************************************************
+// Hardware vertical scroll
+//
+// SSD1351_CMD_STARTLINE rotates the whole panel through display RAM, so once
+// it is non-zero logical row y lives in RAM row (y + scrollStart) mod 128.
+// setWindow() translates rows. A window that runs past the last RAM row is
+// opened up to that row, and the pixel streams move on to the rest of it,
+// from RAM row 0, when the first part is full.
+//*****************************************************************************
 
-  for (delay = 0; delay < 100; delay++);
+#define RAM_ROWS  128   // display RAM height, also behind the 96-row panel
 
+static unsigned char scrollStart = 0;
+static unsigned long splitLeft = 0;   // pixels until the second part
+static unsigned char splitX0, splitX1, splitY1;
 
-  // RESET high
+// Largest part of a count-pixel stream that fits before the window splits
+static unsigned long splitRun(unsigned long count) {
+        return (splitLeft && count > splitLeft) ? splitLeft : count;
+}
 
-  GPIOPinWrite(OLED_RESET_BASE, OLED_RESET_PIN, OLED_RESET_PIN);
+static void splitAdvance(unsigned long pixels) {
+        if (!splitLeft) return;
 
+        splitLeft -= pixels;
+        if (splitLeft == 0) {
+                setRamWindow(splitX0, 0, splitX1, splitY1);
+        }
+}
 
-    // Initialization Sequence
+// Set the RAM write window inside an open transaction and leave the
+// controller in WRITERAM mode with DC high, ready for pixel data
+void setWindow(unsigned char x0, unsigned char y0,
+               unsigned char x1, unsigned char y1) {
+        unsigned char ry0, ry1;
+
+        splitLeft = 0;
+        if (scrollStart == 0) {
+                setRamWindow(x0, y0, x1, y1);
+                return;
+        }
+
+        ry0 = (y0 + scrollStart) % RAM_ROWS;
+        ry1 = (y1 + scrollStart) % RAM_ROWS;
+        if (ry0 <= ry1 || y0 > y1 || x0 > x1) {
+                setRamWindow(x0, ry0, x1, ry1);
+                return;
+        }
+
+        setRamWindow(x0, ry0, x1, RAM_ROWS - 1);
+        splitX0 = x0;
+        splitX1 = x1;
+        splitY1 = ry1;
+        splitLeft = (unsigned long)(RAM_ROWS - ry0) * (x1 - x0 + 1);
+}
 
-  writeCommand(SSD1351_CMD_COMMANDLOCK);  // set command lock
-  writeData(0x12);
-  writeCommand(SSD1351_CMD_COMMANDLOCK);  // set command lock
-  writeData(0xB1);
+// True while the current window is split by scrolling; DMA can only
+// stream into a single window
+int windowSplit(void) {
+        return splitLeft != 0;
+}
 
-  writeCommand(SSD1351_CMD_DISPLAYOFF);         // 0xAE
+// Stream the same 16-bit color count times inside an open transaction
+void sendColor(unsigned int color, unsigned long count) {
+        while (count > 0) {
+                unsigned long n = splitRun(count);
 
-  writeCommand(SSD1351_CMD_CLOCKDIV);       // 0xB3
-  writeCommand(0xF1);                     // 7:4 = Oscillator Frequency, 3:0 = CLK Div Ratio (A[3:0]+1 = 1..16)
+                sendColorRun(color, n);
+                splitAdvance(n);
+                count -= n;
+        }
+}
 
-  writeCommand(SSD1351_CMD_MUXRATIO);
-  writeData(127);
+// Stream count 16-bit pixels from a buffer inside an open transaction
+void sendPixels(const unsigned short *pixels, unsigned long count) {
+        while (count > 0) {
+                unsigned long n = splitRun(count);
 
-  writeCommand(SSD1351_CMD_SETREMAP);
-  writeData(0x74);
+                sendPixelRun(pixels, n);
+                splitAdvance(n);
+                pixels += n;
+                count -= n;
+        }
+}
 
-  writeCommand(SSD1351_CMD_SETCOLUMN);
-  writeData(0x00);
-  writeData(0x7F);
-  writeCommand(SSD1351_CMD_SETROW);
-  writeData(0x00);
-  writeData(0x7F);
+// Point the controller at (x, y) for a single pixel. If the RAM pointer is
+// already there the current window is kept, whatever its size; otherwise a
+// one-column window is opened so a glyph or line walking down a column
+// carries on without new address commands.
+void setPixelWindow(int x, int y) {
+        y = (y + scrollStart) % RAM_ROWS;
+
+        if (winValid && ramWrite && !halfPixel && ptrX == x && ptrY == y) {
+                displayElidedBytes += 7;
+                setDC(1);
+                return;
+        }
+        splitLeft = 0;
+        setRamWindow(x, y, x, RAM_ROWS - 1);
+}
 
-  writeCommand(SSD1351_CMD_STARTLINE);      // 0xA1
-  if (SSD1351HEIGHT == 96) {
-    writeData(96);
-  } else {
-    writeData(0);
-  }
+//*****************************************************************************
+// Scroll rows top..top+height-1 up by lines (down if negative) and clear
+// the rows that come into view to bg. The SSD1351 can only scroll the whole
+// panel, so a full-height region moves in hardware for the cost of one
+// command plus the exposed rows. A partial region is shifted in the
+// framebuffer when there is one. Otherwise nothing can move it and 0 is
+// returned so the caller repaints the region itself.
+int scrollRegion(int top, int height, int lines, unsigned int bg) {
+        if ((top < 0) || (height <= 0) || (top + height > SSD1351HEIGHT)) return 0;
+        if (lines == 0) return 1;
+
+        if ((lines >= height) || (lines <= -height)) {
+                fillRect(0, top, SSD1351WIDTH, height, bg);
+                return 1;
+        }
+
+        // the start line moves RAM rows, which are only display rows in
+        // rotation 0
+        if ((top == 0) && (height == SSD1351HEIGHT) && (displayRotation == 0)) {
+                // RAM copies must match the panel before they are shifted
+                flush();
+
+                scrollStart = (scrollStart + lines + RAM_ROWS) % RAM_ROWS;
+                // relative to the start line Adafruit_Init() picked
+                startWrite();
+                sendCommand(SSD1351_CMD_STARTLINE);
+                sendData((scrollStart + (SSD1351HEIGHT == 96 ? 96 : 0)) % RAM_ROWS);
+                endWrite();
+
+#if defined SSD1351_FRAMEBUFFER
+                fbScroll(top, height, lines);
+#elif defined SSD1351_BANDED
+                bandScroll(lines);
+#endif
+        } else {
+#ifdef SSD1351_FRAMEBUFFER
+                fbScroll(top, height, lines);
+                fbMarkDirty(0, top, SSD1351WIDTH, height);
+#else
+                return 0;
+#endif
+        }
+
+        if (lines > 0) {
+                fillRect(0, top + height - lines, SSD1351WIDTH, lines, bg);
+        } else {
+                fillRect(0, top, SSD1351WIDTH, -lines, bg);
+        }
+        return 1;
+}
+
+//*****************************************************************************
+// Rotation
+//
+// SETREMAP mirrors the column and COM scan order and selects the address
+// increment, so the controller turns the image and nothing is transformed
+// per pixel. Odd rotations use vertical increment with the window commands
+// swapped, which still fills a window one logical row at a time; the window
+// shadow and the pixel streams keep working in logical coordinates.
+// Hardware scrolling is reset, since the start line only moves display rows
+// in rotation 0. Framebuffer and banded builds keep their RAM copies at the
+// panel size, so they take odd rotations only on a square panel.
+//*****************************************************************************
+
+static const unsigned char remapRotation[4] = { 0x74, 0x77, 0x66, 0x65 };
+
+void setDisplayRotation(unsigned char r) {
+        r &= 3;
+#if defined SSD1351_FRAMEBUFFER || defined SSD1351_BANDED
+        if ((r & 1) && (SSD1351WIDTH != SSD1351HEIGHT)) return;
+#endif
+
+        displayRotation = r;
+
+        startWrite();
+        sendCommand(SSD1351_CMD_SETREMAP);
+        sendData(remapRotation[r]);
+        if (scrollStart != 0) {
+                scrollStart = 0;
+                sendCommand(SSD1351_CMD_STARTLINE);
+                sendData((SSD1351HEIGHT == 96) ? 96 : 0);
+        }
+        endWrite();
+
+#ifdef SSD1351_FRAMEBUFFER
+        // the next flush shows the whole image in the new orientation
+        fbMarkDirty(0, 0, SSD1351WIDTH, SSD1351HEIGHT);
+#endif
+}
+
+int getDisplayRotation(void) {
+        return displayRotation;
+}
+
+//*****************************************************************************
+
+void writeCommand(unsigned char c) {
 
+//TODO 1
+/* Write a function to send a command byte c to the OLED via
+*  SPI.
+*/
+        startWrite();
+        sendCommand(c);
+        endWrite();
+}
+//*****************************************************************************
 
-  writeCommand(SSD1351_CMD_DISPLAYOFFSET);  // 0xA2
-  writeData(0x0);
+void writeData(unsigned char c) {
 
-  writeCommand(SSD1351_CMD_SETGPIO);
-  writeData(0x00);
+//TODO 2
+/* Write a function to send a data byte c to the OLED via
+*  SPI.
+*/
+        startWrite();
+        sendData(c);
+        endWrite();
+}
+
+//*****************************************************************************
+//*****************************************************************************
+// Initialization sequence
+//
+// Each entry is a command, a count byte and that many data bytes; none of
+// them has to be followed by a pause. The CLOCKDIV,
+// PRECHARGE and VCOMH values have always been sent with D/C low, as in the
+// original Adafruit sequence, so they appear as commands of their own.
+//*****************************************************************************
+
+static const unsigned char initSequence[] = {
+  SSD1351_CMD_COMMANDLOCK, 1, 0x12,
+  SSD1351_CMD_COMMANDLOCK, 1, 0xB1,
+  SSD1351_CMD_DISPLAYOFF, 0,
+  SSD1351_CMD_CLOCKDIV, 0,
+  0xF1, 0,                      // 7:4 = Oscillator Frequency, 3:0 = CLK Div Ratio
+  SSD1351_CMD_MUXRATIO, 1, 127,
+  SSD1351_CMD_SETREMAP, 1, 0x74,
+  SSD1351_CMD_SETCOLUMN, 2, 0x00, 0x7F,
+  SSD1351_CMD_SETROW, 2, 0x00, 0x7F,
+  SSD1351_CMD_STARTLINE, 1, (SSD1351HEIGHT == 96) ? 96 : 0,
+  SSD1351_CMD_DISPLAYOFFSET, 1, 0x00,
+  SSD1351_CMD_SETGPIO, 1, 0x00,
+  SSD1351_CMD_FUNCTIONSELECT, 1, 0x01,   // internal (diode drop)
+  SSD1351_CMD_PRECHARGE, 0,
+  0x32, 0,
+  SSD1351_CMD_VCOMH, 0,
+  0x05, 0,
+  SSD1351_CMD_NORMALDISPLAY, 0,
+  SSD1351_CMD_CONTRASTABC, 3, 0xC8, 0x80, 0xC8,
+  SSD1351_CMD_CONTRASTMASTER, 1, 0x0F,
+  SSD1351_CMD_SETVSL, 3, 0xA0, 0xB5, 0x55,
+  SSD1351_CMD_PRECHARGE2, 1, 0x01,
+  SSD1351_CMD_DISPLAYON, 0,
+};
+
+// RES# must be held low for at least 2 us; both waits have 5x margin
+#define RESET_LOW_US       10
+#define RESET_RECOVERY_US  10
+
+// Busy-waits on the timeout of a one-shot counting 80 MHz system clocks
+static void delayUs(unsigned long us) {
+  Timer_IF_Init(OLED_DELAY_TIMER_PRCM, OLED_DELAY_TIMER_BASE,
+                TIMER_CFG_ONE_SHOT, TIMER_A, 0);
+  MAP_TimerLoadSet(OLED_DELAY_TIMER_BASE, TIMER_A, us * (80000000 / 1000000));
+  MAP_TimerIntClear(OLED_DELAY_TIMER_BASE, TIMER_TIMA_TIMEOUT);
+  MAP_TimerEnable(OLED_DELAY_TIMER_BASE, TIMER_A);
+
+  while (!(MAP_TimerIntStatus(OLED_DELAY_TIMER_BASE, false) &
+           TIMER_TIMA_TIMEOUT));
+  MAP_TimerIntClear(OLED_DELAY_TIMER_BASE, TIMER_TIMA_TIMEOUT);
+}
+
+void Adafruit_Init(void){
 
-  writeCommand(SSD1351_CMD_FUNCTIONSELECT);
-  writeData(0x01); // internal (diode drop)
-  //writeData(0x01); // external bias
+//TODO 3
+/* NOTE: This function assumes that the RESET pin of the 
+*  OLED has been wired to GPIO28, pin 18 (P2.2). If you 
+*  use a different pin for the OLED reset, then you should
+*  update the GPIOPinWrite commands below that set RESET 
+*  high or low.
+*/
 
-//    writeCommand(SSSD1351_CMD_SETPHASELENGTH);
-//    writeData(0x32);
+  const unsigned char *p = initSequence;
+  const unsigned char *end = initSequence + sizeof(initSequence);
+  unsigned char n;
 
-  writeCommand(SSD1351_CMD_PRECHARGE);          // 0xB1
-  writeCommand(0x32);
 
-  writeCommand(SSD1351_CMD_VCOMH);              // 0xBE
-  writeCommand(0x05);
+  // RESET low (pin 45)
+  GPIOPinWrite(OLED_RESET_BASE, OLED_RESET_PIN, 0);
+  delayUs(RESET_LOW_US);
 
-  writeCommand(SSD1351_CMD_NORMALDISPLAY);      // 0xA6
+  // RESET high
+  GPIOPinWrite(OLED_RESET_BASE, OLED_RESET_PIN, OLED_RESET_PIN);
+  delayUs(RESET_RECOVERY_US);
 
-  writeCommand(SSD1351_CMD_CONTRASTABC);
-  writeData(0xC8);
-  writeData(0x80);
-  writeData(0xC8);
+  // the controller's window, RAM pointer and start line are back to their
+  // defaults
+  winValid = 0;
+  scrollStart = 0;
 
-  writeCommand(SSD1351_CMD_CONTRASTMASTER);
-  writeData(0x0F);
 
-  writeCommand(SSD1351_CMD_SETVSL );
-  writeData(0xA0);
-  writeData(0xB5);
-  writeData(0x55);
+    // Initialization Sequence
 
-  writeCommand(SSD1351_CMD_PRECHARGE2);
-  writeData(0x01);
+#ifdef SSD1351_3WIRE
+  // GSPI comes up with 8-bit words; switch to 9 before the first command
+  setLinkMode(linkMode);
+#endif
+
+  // the whole table goes out in one CS cycle
+  startWrite();
+  while (p < end) {
+    sendCommand(*p++);
+    n = *p++;
+    while (n--) {
+      sendData(*p++);
+    }
+  }
+  endWrite();
 
-  writeCommand(SSD1351_CMD_DISPLAYON);      //--turn on oled panel
+  // the table programs rotation 0
+  if (displayRotation != 0) {
+    setDisplayRotation(displayRotation);
+  }
 }
 
 /***********************************/
 
 void goTo(int x, int y) {
-  if ((x >= SSD1351WIDTH) || (y >= SSD1351HEIGHT)) return;
+  if ((x >= width()) || (y >= height())) return;
 
   // set x and y coordinate
-  writeCommand(SSD1351_CMD_SETCOLUMN);
-  writeData(x);
-  writeData(SSD1351WIDTH-1);
+  startWrite();
+  setWindow(x, y, width()-1, height()-1);
+  endWrite();
+}
+
+// Open a w x h RAM window at (x, y) inside a transaction started with
+// startWrite(); follow it with pushColors() or sendColor(). Like goTo(),
+// this goes straight to the panel, past any framebuffer or display list.
+void setAddrWindow(int x, int y, int w, int h) {
+  setWindow(x, y, x+w-1, y+h-1);
+}
 
-  writeCommand(SSD1351_CMD_SETROW);
-  writeData(y);
-  writeData(SSD1351HEIGHT-1);
+// Stream n RGB565 pixels into the window set by setAddrWindow()
+void pushColors(const unsigned short *colors, unsigned long n) {
+  sendPixels(colors, n);
+}
 
-  writeCommand(SSD1351_CMD_WRITERAM);
+// Draw a w x h RGB565 image, rows stored left to right, clipped to the
+// screen. The visible part goes out as one window in one transaction.
+void drawRGBBitmap(int x, int y, const unsigned short *bitmap, int w, int h) {
+  int stride = w;
+  int x0 = x, y0 = y;
+
+  // clip, moving the start of the image along with it
+  if (!clipRect(&x, &y, &w, &h)) return;
+  bitmap += (long)(y - y0) * stride + (x - x0);
+
+#ifdef SSD1351_FRAMEBUFFER
+  fbDrawBitmap(x, y, bitmap, w, h, stride);
+#else
+#ifdef SSD1351_BANDED
+  if (bandDrawBitmap(x, y, bitmap, w, h, stride)) return;
+#endif
+  startWrite();
+  setWindow(x, y, x+w-1, y+h-1);
+  if (stride == w) {
+    sendPixels(bitmap, (unsigned long)w*h);
+  } else {
+    int j;
+
+    for (j = 0; j < h; j++) {
+      sendPixels(bitmap + (long)j*stride, w);
+    }
+  }
+  endWrite();
+#endif
 }
 
 unsigned int Color565(unsigned char r, unsigned char g, unsigned char b) {
@@ -216,7 +852,19 @@ unsigned int Color565(unsigned char r, unsigned char g, unsigned char b) {
 }
 
 void fillScreen(unsigned int fillcolor) {
-  fillRect(0, 0, SSD1351WIDTH, SSD1351HEIGHT, fillcolor);
+  fillRect(0, 0, width(), height(), fillcolor);
+}
+
+// With SSD1351_FRAMEBUFFER or SSD1351_BANDED, drawing only updates RAM;
+// this sends the changed area to the panel. Raw goTo()/writeData() and
+// setAddrWindow()/pushColors() output and the async calls in oled_dma.c
+// always go straight to the panel.
+void flush(void) {
+#if defined SSD1351_FRAMEBUFFER
+  fbFlush();
+#elif defined SSD1351_BANDED
+  bandFlush();
+#endif
 }
 
 /**************************************************************************/
@@ -224,104 +872,63 @@ void fillScreen(unsigned int fillcolor) {
     @brief  Draws a filled rectangle using HW acceleration
 */
 /**************************************************************************/
-void fillRect(unsigned int x, unsigned int y, unsigned int w, unsigned int h, unsigned int fillcolor)
+void fillRect(int x, int y, int w, int h, unsigned int fillcolor)
 {
-  unsigned int i;
-
-  // Bounds check
-  if ((x >= SSD1351WIDTH) || (y >= SSD1351HEIGHT))
-    return;
-
-  // Y bounds check
-  if (y+h > SSD1351HEIGHT)
-  {
-    h = SSD1351HEIGHT - y - 1;
-  }
-
-  // X bounds check
-  if (x+w > SSD1351WIDTH)
-  {
-    w = SSD1351WIDTH - x - 1;
-  }
-
-  // set location
-  writeCommand(SSD1351_CMD_SETCOLUMN);
-  writeData(x);
-  writeData(x+w-1);
-  writeCommand(SSD1351_CMD_SETROW);
-  writeData(y);
-  writeData(y+h-1);
-  // fill!
-  writeCommand(SSD1351_CMD_WRITERAM);
-
-  for (i=0; i < w*h; i++) {
-    writeData(fillcolor >> 8);
-    writeData(fillcolor);
-  }
+  // trim to the clip rectangle once
+  if (!clipRect(&x, &y, &w, &h)) return;
+
+#ifdef SSD1351_FRAMEBUFFER
+  fbFillRect(x, y, w, h, fillcolor);
+#else
+#ifdef SSD1351_BANDED
+  if (bandFillRect(x, y, w, h, fillcolor)) return;
+#endif
+  // set location and fill in a single transaction
+  startWrite();
+  setWindow(x, y, x+w-1, y+h-1);
+  sendColor(fillcolor, (unsigned long)w*h);
+  endWrite();
+#endif
 }
 
 void drawFastVLine(int x, int y, int h, unsigned int color) {
-
-  unsigned int i;
-  // Bounds check
-  if ((x >= SSD1351WIDTH) || (y >= SSD1351HEIGHT))
-    return;
-
-  // X bounds check
-  if (y+h > SSD1351HEIGHT)
-  {
-    h = SSD1351HEIGHT - y - 1;
-  }
-
-  if (h < 0) return;
-
-  // set location
-  writeCommand(SSD1351_CMD_SETCOLUMN);
-  writeData(x);
-  writeData(x);
-  writeCommand(SSD1351_CMD_SETROW);
-  writeData(y);
-  writeData(y+h-1);
-  // fill!
-  writeCommand(SSD1351_CMD_WRITERAM);
-
-  for (i=0; i < h; i++) {
-    writeData(color >> 8);
-    writeData(color);
-  }
+  int w = 1;
+
+  if (!clipRect(&x, &y, &w, &h)) return;
+
+#ifdef SSD1351_FRAMEBUFFER
+  fbFillRect(x, y, 1, h, color);
+#else
+#ifdef SSD1351_BANDED
+  if (bandFillRect(x, y, 1, h, color)) return;
+#endif
+  // set location and fill in a single transaction
+  startWrite();
+  setWindow(x, y, x, y+h-1);
+  sendColor(color, h);
+  endWrite();
+#endif
 }
 
 
 
 void drawFastHLine(int x, int y, int w, unsigned int color) {
-
-  unsigned int i;
-  // Bounds check
-  if ((x >= SSD1351WIDTH) || (y >= SSD1351HEIGHT))
-    return;
-
-  // X bounds check
-  if (x+w > SSD1351WIDTH)
-  {
-    w = SSD1351WIDTH - x - 1;
-  }
-
-  if (w < 0) return;
-
-  // set location
-  writeCommand(SSD1351_CMD_SETCOLUMN);
-  writeData(x);
-  writeData(x+w-1);
-  writeCommand(SSD1351_CMD_SETROW);
-  writeData(y);
-  writeData(y);
-  // fill!
-  writeCommand(SSD1351_CMD_WRITERAM);
-
-  for (i=0; i < w; i++) {
-    writeData(color >> 8);
-    writeData(color);
-  }
+  int h = 1;
+
+  if (!clipRect(&x, &y, &w, &h)) return;
+
+#ifdef SSD1351_FRAMEBUFFER
+  fbFillRect(x, y, w, 1, color);
+#else
+#ifdef SSD1351_BANDED
+  if (bandFillRect(x, y, w, 1, color)) return;
+#endif
+  // set location and fill in a single transaction
+  startWrite();
+  setWindow(x, y, x+w-1, y);
+  sendColor(color, w);
+  endWrite();
+#endif
 }
 
 
@@ -329,13 +936,19 @@ void drawFastHLine(int x, int y, int w, unsigned int color) {
 
 void drawPixel(int x, int y, unsigned int color)
 {
-  if ((x >= SSD1351WIDTH) || (y >= SSD1351HEIGHT)) return;
-  if ((x < 0) || (y < 0)) return;
-
-  goTo(x, y);
-
-  writeData(color >> 8);
-  writeData(color);
+  if (!clipContains(x, y)) return;
+
+#ifdef SSD1351_FRAMEBUFFER
+  fbDrawPixel(x, y, color);
+#else
+#ifdef SSD1351_BANDED
+  if (bandFillRect(x, y, 1, 1, color)) return;
+#endif
+  startWrite();
+  setPixelWindow(x, y);
+  sendColor(color, 1);
+  endWrite();
+#endif
 }
 
 
@@ -16,6 +16,9 @@
   BSD license, all text above must be included in any redistribution
  ****************************************************/
 
+#ifndef _ADAFRUIT_SSD1351_H
+#define _ADAFRUIT_SSD1351_H
+
 #define SSD1351WIDTH 128
 #define SSD1351HEIGHT 128  // SET THIS TO 96 FOR 1.27"!
 
@@ -45,6 +48,52 @@
   #error "RGB and BGR can not both be defined for SSD1351_COLORODER."
 #endif
 
+// Uncomment to draw into a 128x128 RGB565 framebuffer in RAM (32 KB) instead
+// of straight to the panel. Nothing is shown until flush() is called.
+// #define SSD1351_FRAMEBUFFER
+
+// Uncomment to record drawing into a display list and render it on flush()
+// one band of SSD1351_BAND_ROWS rows at a time. The band buffer and list
+// together need about 8 KB instead of 32 KB.
+// #define SSD1351_BANDED
+#define SSD1351_BAND_ROWS  16
+#define SSD1351_DISPLAY_LIST_SIZE  384
+
+#if defined SSD1351_FRAMEBUFFER && defined SSD1351_BANDED
+  #error "SSD1351_FRAMEBUFFER and SSD1351_BANDED can not both be defined."
+#endif
+
+// Uncomment to keep recently drawn glyphs expanded to RGB565 in an arena
+// of SSD1351_GLYPH_CACHE_BYTES, so repeated text is sent straight from RAM.
+// Banded builds already render glyphs from their display list.
+// #define SSD1351_GLYPH_CACHE
+#define SSD1351_GLYPH_CACHE_BYTES  3072
+
+#if defined SSD1351_GLYPH_CACHE && defined SSD1351_BANDED
+  #error "SSD1351_GLYPH_CACHE and SSD1351_BANDED can not both be defined."
+#endif
+
+// Uncomment for 3-wire serial: D/C is sent as a 9th bit ahead of every byte
+// instead of on a GPIO, and PIN_61 is no longer used. The panel's BS0/BS1
+// straps must select 3-wire SPI.
+// #define SSD1351_3WIRE
+
+#ifdef SSD1351_3WIRE
+  // CH0CONF word lengths (bits - 1) for 9-bit bytes and 18-bit pixels
+  #define SSD1351_WL_9   0x00000400
+  #define SSD1351_WL_18  0x00000880
+  // one pixel as two 9-bit data words
+  #define SSD1351_PIXEL_WORD(c)  (0x20100UL | (((c) & 0xFF00UL) << 1) | ((c) & 0xFFUL))
+#endif
+
+// SSD1351 serial clock limit (50 ns minimum cycle time)
+#define SSD1351_MAX_BIT_RATE  20000000
+
+// SPI link modes for setLinkMode()
+#define SSD1351_LINK_BYTE    0  // 8-bit words, RX drained after every byte
+#define SSD1351_LINK_WORD16  1  // one pixel per 16-bit word, TX only + FIFO
+#define SSD1351_LINK_WORD32  2  // two pixels per 32-bit word, TX only + FIFO
+
 // Timing Delays
 #define SSD1351_DELAYS_HWFILL	    (3)
 #define SSD1351_DELAYS_HWLINE       (1)
@@ -97,10 +146,22 @@ class Adafruit_SSD1351  : public virtual Adafruit_GFX {
 	
   // drawing primitives!
   void drawPixel(int x, int y, unsigned int color);
-  void fillRect(unsigned int x0, unsigned int y0, unsigned int w, unsigned int h, unsigned int color);
+  void fillRect(int x0, int y0, int w, int h, unsigned int color);
   void drawFastHLine(int x, int y, int w, unsigned int color);
   void drawFastVLine(int x, int y, int h, unsigned int color);
   void fillScreen(unsigned int fillcolor);
+  void drawRGBBitmap(int x, int y, const unsigned short *bitmap, int w, int h);
+
+  // push pending framebuffer changes to the panel (no-op without one)
+  void flush(void);
+
+  // returns 0 if the region could not be moved and must be repainted
+  int scrollRegion(int top, int height, int lines, unsigned int bg);
+
+  // program the controller's address remap for rotation 0-3; use
+  // setRotation() so the GFX clipping follows
+  void setDisplayRotation(unsigned char r);
+  int getDisplayRotation(void);
 
   void invert(char);
   // commands
@@ -114,6 +175,34 @@ class Adafruit_SSD1351  : public virtual Adafruit_GFX {
   void writeData(unsigned char d);
   void writeCommand(unsigned char c);
 
+  // transactions: CS stays low from startWrite() to the matching endWrite()
+  void startWrite(void);
+  void sendCommand(unsigned char c);
+  void sendData(unsigned char d);
+  void sendColor(unsigned int color, unsigned long count);
+  void sendPixels(const unsigned short *pixels, unsigned long count);
+  void setAddrWindow(int x, int y, int w, int h);
+  void pushColors(const unsigned short *colors, unsigned long n);
+
+  // SPI link configuration; see oled_bench.c for a tuner
+  void setLinkMode(int mode);
+  int getLinkMode(void);
+  void setLinkBitRate(unsigned long rate);
+
+  // bytes sent through the blocking path since reset, for benchmarks
+  extern unsigned long displayBytes;
+  void endWrite(void);
+  void setWindow(unsigned char x0, unsigned char y0, unsigned char x1, unsigned char y1);
+  void setPixelWindow(int x, int y);
+  void advanceWindow(unsigned long pixels);
+  int windowSplit(void);
+
+  // window command bytes skipped because the controller already had them
+  extern unsigned long displayElidedBytes;
+
+  // set while an asynchronous transfer (oled_dma.c) owns the bus
+  extern volatile unsigned char displayBusy;
+
 
   void writeData_unsafe(unsigned int d);
 
@@ -128,3 +217,5 @@ class Adafruit_SSD1351  : public virtual Adafruit_GFX {
   PortReg *csport, *rsport, *sidport, *sclkport;
   PortMask cspinmask, rspinmask, sidpinmask, sclkpinmask;
 */
+
+#endif // _ADAFRUIT_SSD1351_H
@@ -65,6 +65,9 @@
 #include "gpio_if.h"
 #include "Adafruit_SSD1351.h"
 #include "Adafruit_GFX.h"
+#include "oled_bench.h"
+#include "oled_dma.h"
+#include "oled_widget.h"
 #include "pin_mux_config.h"
 
 //*****************************************************************************
@@ -76,6 +79,13 @@
 
 #define SPI_IF_BIT_RATE   1000000
 
+// OLED pixel link profile (SSD1351_LINK_BYTE/WORD16/WORD32); the benchmark
+// build tries every mode and rate and prints the best one for this board
+#define OLED_LINK_MODE    SSD1351_LINK_BYTE
+
+// Uncomment to print display throughput numbers over UART at startup
+//#define OLED_BENCHMARK
+
 
 // SysTick Timing
 #define CPU_HZ        80000000UL
@@ -99,6 +109,7 @@
 #define MAX_USERNAME_LENGTH   16
 #define MAX_COMMAND_NAME_LENGTH  16
 #define ATTRIBUTE_SEPARATOR  "~"
+#define MESSAGE_LINES  4    // screen lines a message wraps over
 
 
 // Remote button related
@@ -177,6 +188,13 @@ static unsigned long my_color = YELLOW;
 static char my_color_str[MAX_USERNAME_LENGTH + 1 ] = "yellow";
 static volatile int update_me = 0;
 
+// The chat screen, bottom to top; render() repaints only what changed
+static Screen screen;
+static Widget sender_text, receive_text;
+static Widget divider;
+static Widget my_text, send_text;
+static Widget status_bar;
+
 
 // Remote button related
 static uint16_t prev_key_signal = 0;
@@ -417,45 +435,54 @@ static void run_command(){
 //                      OLED Screen Related
 //-----------------------------------------------------------------------------
 
-static void drawText(
-    int x, int y, const char *str,
-    unsigned int fg, unsigned int bg,
-    unsigned char size
-){
-    while(*str) {
-        drawChar(x, y, (unsigned char)*str, fg, bg, size);
-        x += 6 * size;
-        str++;
-    }
-}
+// The update functions only change widgets; drawUI() and the main loop
+// call screenRender() to put the changes on the panel
 
 static void updateSenderUsername(){
-    fillRect(0, 0, 64, 8, BLACK);
-    drawText(0, 0, sender_username, sender_color, BLACK, 1);
+    widgetSetColor(&sender_text, sender_color, BLACK);
+    widgetSetText(&sender_text, sender_username);
     update_sender = 0;
 }
 
 static void updateMyUsername(){
-    fillRect(0, 70, 64, 8, BLACK);
-    drawText(0, 70, my_username, my_color, BLACK, 1);
+    widgetSetColor(&my_text, my_color, BLACK);
+    widgetSetText(&my_text, my_username);
     update_me = 0;
 }
 
-static void drawUI(void){
-    fillScreen(BLACK);
-    updateSenderUsername();
-    drawLine(0, 63, 127, 63, WHITE);
-    updateMyUsername();
-}
+static void updateMessages(void){
+    char status[TEXTFIELD_MAX_COLS + 1];
 
-static void drawMessages(void){
     // Top area
-    fillRect(0, 12, 127, 8, BLACK);
-    drawText(0, 12, msg_receive, WHITE, BLACK, 1);
+    widgetSetText(&receive_text, msg_receive);
 
     // Bottom area
-    fillRect(0, 82, 127, 8, BLACK);
-    drawText(0, 82, msg_send, WHITE, BLACK, 1);
+    widgetSetText(&send_text, msg_send);
+    sprintf(status, "%d/%d", msg_send_length, MAX_MSG_LENGTH);
+    widgetSetText(&status_bar, status);
+}
+
+static void drawUI(void){
+    widgetText(&sender_text, 0, 0, MAX_USERNAME_LENGTH, 1, sender_color, BLACK);
+    widgetParagraph(&receive_text, 0, 12, TEXTBLOCK_MAX_COLS, MESSAGE_LINES, 1, WHITE, BLACK);
+    widgetDivider(&divider, 0, 63, SSD1351WIDTH, WHITE);
+    widgetText(&my_text, 0, 70, MAX_USERNAME_LENGTH, 1, my_color, BLACK);
+    widgetParagraph(&send_text, 0, 82, TEXTBLOCK_MAX_COLS, MESSAGE_LINES, 1, WHITE, BLACK);
+    widgetStatusBar(&status_bar, SSD1351HEIGHT - 10, 1, WHITE, BLUE);
+
+    screenInit(&screen);
+    screenAdd(&screen, &sender_text);
+    screenAdd(&screen, &receive_text);
+    screenAdd(&screen, &divider);
+    screenAdd(&screen, &my_text);
+    screenAdd(&screen, &send_text);
+    screenAdd(&screen, &status_bar);
+
+    updateSenderUsername();
+    updateMyUsername();
+    updateMessages();
+    screenRender(&screen);
+    flush();
 }
 
 //-----------------------------------------------------------------------------
@@ -533,7 +560,15 @@ static void SPIInit(){
 
 static void OLEDInit(){
     Adafruit_Init();
-    drawUI();
+    setLinkMode(OLED_LINK_MODE);
+    displayDMAInit();
+#ifdef OLED_BENCHMARK
+    benchDisplay();
+#endif
+
+    // Clear the screen in the background while the rest of the board
+    // comes up; drawUI() waits for it to finish
+    fillScreenAsync(BLACK, NULL);
 }
 
 //-----------------------------------------------------------------------------
@@ -700,6 +735,8 @@ int main(void){
     Message("Initializing UARTA1...\n\r");
     UARTA1Init();
 
+    drawUI();
+
     Message("\t\t****************************************************\n\r");
     Message("\t\t*              Ready to text messages              *\n\r");
     Message("\t\t****************************************************\n\r");
@@ -791,23 +828,23 @@ int main(void){
                 case BUTTON_9:
                 case BUTTON_0:
                     handle_remote_button_pressed(button_code);
-                    drawMessages();
+                    updateMessages();
                     break;
 
                 case BUTTON_DELETE:
                     delete_char_from_sending();
-                    drawMessages();
+                    updateMessages();
                     break;
 
                 case BUTTON_SEND:
                     if(msg_send[0] == '/'){
                         run_command();
-                        drawMessages();
+                        updateMessages();
                         break;
                     }
 
                     send_message();        // sends over UART0 and clears compose
-                    drawMessages();
+                    updateMessages();
                     break;
 
                 default:
@@ -818,7 +855,7 @@ int main(void){
             if(msg_received_fully) {
                 msg_received_fully = 0;
                 Report("Just got: %s\r\n", msg_receive);
-                drawMessages();
+                updateMessages();
 
                 msg_receive_length = 0;
             }
@@ -830,6 +867,11 @@ int main(void){
             if(update_sender){
                 updateSenderUsername();
             }
+
+            screenRender(&screen);
+
+            // no-op unless SSD1351_FRAMEBUFFER or SSD1351_BANDED is enabled
+            flush();
         }
     }
 }
@@ -0,0 +1,411 @@
+/* Banded renderer for the SSD1351.
+*
+*  Instead of a full 32 KB framebuffer, draw calls are recorded into a
+*  display list of rectangles and glyphs. The list describes everything
+*  drawn since the last full-screen fill, on a black background. flush()
+*  renders the rows touched since the previous flush, SSD1351_BAND_ROWS at a
+*  time, into a small buffer and sends each band with one address window.
+*
+*  RGB bitmaps are recorded by address, so in this mode the pixels must
+*  stay unchanged until the next flush().
+*
+*  Runs of single pixels are merged as they are recorded. When the list
+*  fills up, anything hidden under a later opaque rectangle or glyph is
+*  dropped. If that does not free a slot, the pending work is flushed and
+*  drawing goes straight to the panel until the next full-screen fill
+*  starts a new list.
+*
+*  The whole module compiles away unless SSD1351_BANDED is defined.
+*/
+
+#include <string.h>
+
+#include "Adafruit_GFX.h"
+#include "Adafruit_SSD1351.h"
+#include "oled_band.h"
+
+#ifdef SSD1351_BANDED
+
+#define OP_RECT  0
+#define OP_CHAR  1
+#define OP_BITMAP  2
+
+typedef struct {
+  unsigned char type;
+  unsigned char w, h;       // OP_CHAR: w is the character, h the text size
+  signed char x, y;
+  unsigned short color;     // OP_BITMAP: slot in bitmaps[]
+  unsigned short bg;        // OP_CHAR: bg == color means transparent
+                            // OP_BITMAP: source row stride in pixels
+} BandOp;
+
+static BandOp displayList[SSD1351_DISPLAY_LIST_SIZE];
+static int opCount = 0;
+static int listFull = 0;    // list overflowed; drawing bypasses it
+
+static const unsigned short *bitmaps[BAND_MAX_BITMAPS];
+static int bitmapCount = 0;
+
+static unsigned short band[SSD1351_BAND_ROWS * SSD1351WIDTH];
+static int bandRows = SSD1351_BAND_ROWS;
+
+// rows and columns touched since the last flush, inclusive
+static int dirtyX0, dirtyY0, dirtyX1, dirtyY1;
+static int dirtyValid = 0;
+
+// area covered by the band being rendered
+static int clipX0, clipY0, clipX1, clipY1;
+
+
+// Bounding box of an op on screen, clipped; returns 0 if fully off screen
+static int opBounds(const BandOp *op, int *x0, int *y0, int *x1, int *y1) {
+  int w = op->w, h = op->h;
+
+  if (op->type == OP_CHAR) {
+    w = 6 * op->h;
+    h = 8 * op->h;
+  }
+
+  *x0 = op->x;
+  *y0 = op->y;
+  *x1 = op->x + w - 1;
+  *y1 = op->y + h - 1;
+
+  if (*x0 < 0) *x0 = 0;
+  if (*y0 < 0) *y0 = 0;
+  if (*x1 > SSD1351WIDTH - 1) *x1 = SSD1351WIDTH - 1;
+  if (*y1 > SSD1351HEIGHT - 1) *y1 = SSD1351HEIGHT - 1;
+
+  return *x0 <= *x1 && *y0 <= *y1;
+}
+
+static int opOpaque(const BandOp *op) {
+  return op->type != OP_CHAR || op->bg != op->color;
+}
+
+static void markDirty(const BandOp *op) {
+  int x0, y0, x1, y1;
+
+  if (!opBounds(op, &x0, &y0, &x1, &y1)) return;
+
+  if (!dirtyValid) {
+    dirtyX0 = x0;
+    dirtyY0 = y0;
+    dirtyX1 = x1;
+    dirtyY1 = y1;
+    dirtyValid = 1;
+    return;
+  }
+  if (x0 < dirtyX0) dirtyX0 = x0;
+  if (y0 < dirtyY0) dirtyY0 = y0;
+  if (x1 > dirtyX1) dirtyX1 = x1;
+  if (y1 > dirtyY1) dirtyY1 = y1;
+}
+
+// Drop every op that is completely hidden by a later opaque op
+static void compactList(void) {
+  int i, j, n;
+  int ax0, ay0, ax1, ay1;
+  int bx0, by0, bx1, by1;
+  unsigned char hidden[SSD1351_DISPLAY_LIST_SIZE];
+
+  for (i = 0; i < opCount; i++) {
+    hidden[i] = !opBounds(&displayList[i], &ax0, &ay0, &ax1, &ay1);
+  }
+
+  for (j = opCount - 1; j > 0; j--) {
+    if (hidden[j] || !opOpaque(&displayList[j])) continue;
+    opBounds(&displayList[j], &bx0, &by0, &bx1, &by1);
+
+    for (i = 0; i < j; i++) {
+      if (hidden[i]) continue;
+      opBounds(&displayList[i], &ax0, &ay0, &ax1, &ay1);
+      if (ax0 >= bx0 && ay0 >= by0 && ax1 <= bx1 && ay1 <= by1) {
+        hidden[i] = 1;
+      }
+    }
+  }
+
+  n = 0;
+  for (i = 0; i < opCount; i++) {
+    if (!hidden[i]) {
+      displayList[n++] = displayList[i];
+    }
+  }
+  opCount = n;
+}
+
+// Returns 0 if the list overflowed and the op must be drawn directly
+static int addOp(const BandOp *op) {
+  if (opCount == SSD1351_DISPLAY_LIST_SIZE) {
+    compactList();
+  }
+  if (opCount == SSD1351_DISPLAY_LIST_SIZE) {
+    bandFlush();
+    listFull = 1;
+    return 0;
+  }
+  displayList[opCount++] = *op;
+  markDirty(op);
+  return 1;
+}
+
+// Slot holding pixels in bitmaps[], taking a free one if needed; slots no
+// longer used by any op are reclaimed. Returns -1 if the table is full.
+static int bitmapSlot(const unsigned short *pixels) {
+  int i, j;
+
+  for (i = 0; i < bitmapCount; i++) {
+    if (bitmaps[i] == pixels) return i;
+  }
+  if (bitmapCount < BAND_MAX_BITMAPS) {
+    bitmaps[bitmapCount] = pixels;
+    return bitmapCount++;
+  }
+
+  for (i = 0; i < bitmapCount; i++) {
+    for (j = 0; j < opCount; j++) {
+      if (displayList[j].type == OP_BITMAP && displayList[j].color == i) break;
+    }
+    if (j == opCount) {
+      bitmaps[i] = pixels;
+      return i;
+    }
+  }
+  return -1;
+}
+
+void bandSetRows(int rows) {
+  bandFlush();
+
+  if (rows < 0) rows = 0;
+  if (rows > SSD1351_BAND_ROWS) rows = SSD1351_BAND_ROWS;
+  bandRows = rows;
+  opCount = 0;
+  bitmapCount = 0;
+  listFull = 0;
+}
+
+int bandGetRows(void) {
+  return bandRows;
+}
+
+int bandFillRect(int x, int y, int w, int h, unsigned int color) {
+  BandOp op;
+  BandOp *last;
+
+  if (bandRows == 0) return 0;
+
+  // clip to the screen
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (x + w > SSD1351WIDTH) w = SSD1351WIDTH - x;
+  if (y + h > SSD1351HEIGHT) h = SSD1351HEIGHT - y;
+  if (w <= 0 || h <= 0) return 1;
+
+  op.type = OP_RECT;
+  op.x = x;
+  op.y = y;
+  op.w = w;
+  op.h = h;
+  op.color = color;
+  op.bg = color;
+
+  // a full-screen fill hides everything recorded so far
+  if (w == SSD1351WIDTH && h == SSD1351HEIGHT) {
+    opCount = 0;
+    bitmapCount = 0;
+    listFull = 0;
+  }
+  if (listFull) return 0;
+
+  // extend the previous rectangle when this one continues it
+  last = &displayList[opCount > 0 ? opCount - 1 : 0];
+  if (opCount > 0 && last->type == OP_RECT && last->color == color) {
+    if (last->x == x && last->w == w && last->y + last->h == y) {
+      markDirty(&op);
+      last->h += h;
+      return 1;
+    }
+    if (last->y == y && last->h == h && last->x + last->w == x) {
+      markDirty(&op);
+      last->w += w;
+      return 1;
+    }
+  }
+
+  return addOp(&op);
+}
+
+int bandDrawChar(int x, int y, unsigned char c, unsigned int color,
+                 unsigned int bg, unsigned char size) {
+  BandOp op;
+
+  if (bandRows == 0 || listFull) return 0;
+
+  // glyphs that do not fit the compact op are recorded pixel by pixel
+  if (x < -128 || y < -128) return 0;
+
+  op.type = OP_CHAR;
+  op.x = x;
+  op.y = y;
+  op.w = c;
+  op.h = size;
+  op.color = color;
+  op.bg = bg;
+
+  return addOp(&op);
+}
+
+int bandDrawBitmap(int x, int y, const unsigned short *pixels, int w, int h,
+                   int stride) {
+  BandOp op;
+  int slot;
+
+  if (bandRows == 0 || listFull) return 0;
+
+  slot = bitmapSlot(pixels);
+  if (slot < 0) {
+    compactList();
+    slot = bitmapSlot(pixels);
+  }
+  if (slot < 0) {
+    bandFlush();
+    listFull = 1;
+    return 0;
+  }
+
+  op.type = OP_BITMAP;
+  op.x = x;
+  op.y = y;
+  op.w = w;
+  op.h = h;
+  op.color = slot;
+  op.bg = stride;
+
+  return addOp(&op);
+}
+
+void bandScroll(int lines) {
+  int x0, y0, x1, y1;
+  int i, n = 0;
+
+  for (i = 0; i < opCount; i++) {
+    BandOp op = displayList[i];
+    int y = op.y - lines;
+
+    if (y < -128 || y > 127) continue;
+    op.y = y;
+    if (!opBounds(&op, &x0, &y0, &x1, &y1)) continue;
+
+    displayList[n++] = op;
+  }
+  opCount = n;
+}
+
+//*****************************************************************************
+// Rendering
+
+// Fill a rectangle in the band, clipped to the current band area
+static void paintRect(int x, int y, int w, int h, unsigned int color) {
+  int x1 = x + w - 1, y1 = y + h - 1;
+  int stride = clipX1 - clipX0 + 1;
+  unsigned short *row;
+  int i, j;
+
+  if (x < clipX0) x = clipX0;
+  if (y < clipY0) y = clipY0;
+  if (x1 > clipX1) x1 = clipX1;
+  if (y1 > clipY1) y1 = clipY1;
+  if (x > x1 || y > y1) return;
+
+  row = &band[(y - clipY0) * stride + (x - clipX0)];
+  for (j = y; j <= y1; j++) {
+    for (i = 0; i <= x1 - x; i++) {
+      row[i] = color;
+    }
+    row += stride;
+  }
+}
+
+static void paintChar(const BandOp *op) {
+  const unsigned char *glyph = getGlyph(op->w);
+  int size = op->h;
+  unsigned char line;
+  int i, j;
+
+  for (i = 0; i < 6; i++) {
+    line = (i == 5) ? 0 : glyph[i];
+    for (j = 0; j < 8; j++) {
+      if (line & 0x1) {
+        paintRect(op->x + i * size, op->y + j * size, size, size, op->color);
+      } else if (op->bg != op->color) {
+        paintRect(op->x + i * size, op->y + j * size, size, size, op->bg);
+      }
+      line >>= 1;
+    }
+  }
+}
+
+static void paintBitmap(const BandOp *op) {
+  const unsigned short *src = bitmaps[op->color];
+  int x = op->x, y = op->y;
+  int x1 = op->x + op->w - 1, y1 = op->y + op->h - 1;
+  int stride = clipX1 - clipX0 + 1;
+  unsigned short *row;
+
+  if (x < clipX0) x = clipX0;
+  if (y < clipY0) y = clipY0;
+  if (x1 > clipX1) x1 = clipX1;
+  if (y1 > clipY1) y1 = clipY1;
+  if (x > x1 || y > y1) return;
+
+  src += (y - op->y) * op->bg + (x - op->x);
+  row = &band[(y - clipY0) * stride + (x - clipX0)];
+  for (; y <= y1; y++) {
+    memcpy(row, src, (x1 - x + 1) * sizeof(band[0]));
+    row += stride;
+    src += op->bg;
+  }
+}
+
+void bandFlush(void) {
+  int i, y;
+  int x0, y0, x1, y1;
+
+  if (!dirtyValid || bandRows == 0) return;
+  dirtyValid = 0;
+
+  clipX0 = dirtyX0;
+  clipX1 = dirtyX1;
+
+  startWrite();
+  for (y = dirtyY0; y <= dirtyY1; y += bandRows) {
+    clipY0 = y;
+    clipY1 = y + bandRows - 1;
+    if (clipY1 > dirtyY1) clipY1 = dirtyY1;
+
+    // background, then every op that reaches into this band in order
+    paintRect(clipX0, clipY0, clipX1 - clipX0 + 1, clipY1 - clipY0 + 1, 0);
+    for (i = 0; i < opCount; i++) {
+      const BandOp *op = &displayList[i];
+
+      if (!opBounds(op, &x0, &y0, &x1, &y1)) continue;
+      if (y1 < clipY0 || y0 > clipY1 || x1 < clipX0 || x0 > clipX1) continue;
+
+      if (op->type == OP_CHAR) {
+        paintChar(op);
+      } else if (op->type == OP_BITMAP) {
+        paintBitmap(op);
+      } else {
+        paintRect(op->x, op->y, op->w, op->h, op->color);
+      }
+    }
+
+    setWindow(clipX0, clipY0, clipX1, clipY1);
+    sendPixels(band, (unsigned long)(clipX1 - clipX0 + 1) * (clipY1 - clipY0 + 1));
+  }
+  endWrite();
+}
+
+#endif /* SSD1351_BANDED */
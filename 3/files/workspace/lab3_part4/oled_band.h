@@ -0,0 +1,40 @@
+/*
+ * oled_band.h
+ *
+ *  Banded rendering for the SSD1351. Enabled by defining SSD1351_BANDED in
+ *  Adafruit_SSD1351.h; drawing is recorded into a display list and
+ *  rendered a few rows at a time into a small band buffer on flush().
+ */
+
+#ifndef OLED_OLED_BAND_H_
+#define OLED_OLED_BAND_H_
+
+// Number of different RGB bitmaps the display list can refer to
+#define BAND_MAX_BITMAPS  8
+
+// Rows rendered per band, 1..SSD1351_BAND_ROWS. 0 turns recording off and
+// draws straight to the panel. The display list is cleared, so call this
+// right after clearing the screen.
+void bandSetRows(int rows);
+int bandGetRows(void);
+
+// Record a draw call. Return 0 when banding is off and the caller should
+// draw directly.
+int bandFillRect(int x, int y, int w, int h, unsigned int color);
+int bandDrawChar(int x, int y, unsigned char c, unsigned int color,
+                 unsigned int bg, unsigned char size);
+
+// x, y, w and h already clipped to the screen; pixels must stay unchanged
+// until the next flush()
+int bandDrawBitmap(int x, int y, const unsigned short *pixels, int w, int h,
+                   int stride);
+
+// Render the dirty area band by band and send it to the panel
+void bandFlush(void);
+
+// Move everything recorded up by lines (down if negative), dropping what
+// leaves the screen; used after a hardware scroll of the whole panel
+void bandScroll(int lines);
+
+
+#endif /* OLED_OLED_BAND_H_ */
@@ -0,0 +1,548 @@
+/* Benchmarks for the SSD1351 driver.
+*
+*  Each benchmark times a drawing workload with a free-running general
+*  purpose timer and prints the elapsed time and the SPI byte rate over
+*  UART. Call benchDisplay() after Adafruit_Init() to run all of them.
+*/
+
+// Standard includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Driverlib includes
+#include "hw_types.h"
+#include "hw_memmap.h"
+#include "timer.h"
+#include "rom.h"
+#include "rom_map.h"
+#include "prcm.h"
+
+// Common interface includes
+#include "timer_if.h"
+#include "uart_if.h"
+
+#include "Adafruit_GFX.h"
+#include "Adafruit_SSD1351.h"
+#include "oled_test.h"
+#include "oled_band.h"
+#include "oled_glyphcache.h"
+#include "oled_bench.h"
+
+
+#define BENCH_TIMER_PRCM  PRCM_TIMERA2
+#define BENCH_TIMER_BASE  TIMERA2_BASE
+#define BENCH_TICKS_PER_US  80
+
+// bytes for a full-screen window: 7 address bytes + 2 per pixel
+#define FULL_SCREEN_BYTES  (7UL + 2UL * SSD1351WIDTH * SSD1351HEIGHT)
+
+
+//*****************************************************************************
+void benchStart(void) {
+  Timer_IF_Init(BENCH_TIMER_PRCM, BENCH_TIMER_BASE, TIMER_CFG_PERIODIC, TIMER_A, 0);
+  MAP_TimerLoadSet(BENCH_TIMER_BASE, TIMER_A, 0xFFFFFFFF);
+  MAP_TimerEnable(BENCH_TIMER_BASE, TIMER_A);
+}
+
+unsigned long benchElapsedUs(void) {
+  unsigned long ticks = Timer_IF_GetCount(BENCH_TIMER_BASE, TIMER_A);
+
+  MAP_TimerDisable(BENCH_TIMER_BASE, TIMER_A);
+  return ticks / BENCH_TICKS_PER_US;
+}
+
+void benchReport(const char *name, unsigned long bytes, unsigned long us) {
+  unsigned long rate = 0;
+
+  if (us > 0) {
+    rate = (unsigned long)(((unsigned long long)bytes * 1000000UL) / us);
+  }
+  Report("%-28s %8lu us %8lu bytes %8lu B/s\n\r", name, us, bytes, rate);
+}
+
+//*****************************************************************************
+// Display bring-up: reset pulse and the init table through the first pixel
+void benchBoot(void) {
+  unsigned long bytes;
+  unsigned long us;
+
+  bytes = displayBytes;
+  benchStart();
+  Adafruit_Init();
+  drawPixel(0, 0, BLACK);
+  flush();
+  us = benchElapsedUs();
+  benchReport("init, reset to first pixel", displayBytes - bytes, us);
+}
+
+//*****************************************************************************
+// Full-screen clear: one CS cycle per byte versus one burst transaction
+void benchFillScreen(void) {
+  unsigned long i;
+  unsigned long us;
+
+  benchStart();
+  goTo(0, 0);
+  for (i = 0; i < 2UL * SSD1351WIDTH * SSD1351HEIGHT; i++) {
+    writeData(0);
+  }
+  us = benchElapsedUs();
+  benchReport("fillScreen, byte at a time", FULL_SCREEN_BYTES, us);
+
+  benchStart();
+  fillScreen(BLACK);
+  flush();
+  us = benchElapsedUs();
+  benchReport("fillScreen, burst", FULL_SCREEN_BYTES, us);
+}
+
+//*****************************************************************************
+// Scattered single pixels: every one is a window command followed by data,
+// so this is dominated by D/C switching. Run it once with and once without
+// SSD1351_3WIRE to compare the transports.
+void benchPixels(void) {
+  unsigned long bytes;
+  unsigned long us;
+  int i;
+
+  bytes = displayBytes;
+  benchStart();
+  for (i = 0; i < 1024; i++) {
+    drawPixel((i * 37) & (SSD1351WIDTH - 1), (i * 11) & (SSD1351HEIGHT - 1), WHITE);
+  }
+  flush();
+  us = benchElapsedUs();
+  benchReport("drawPixel x1024", displayBytes - bytes, us);
+}
+
+//*****************************************************************************
+// Text: 8 lines of a short message, white on black, as on the chat screen.
+// With SSD1351_GLYPH_CACHE the second pass comes from the cache.
+static void benchMessage(const char *name) {
+  static const char line[] = "hello from the cc3200";
+  unsigned long bytes;
+  unsigned long us;
+  int i, j;
+
+  bytes = displayBytes;
+  benchStart();
+  for (j = 0; j < 8; j++) {
+    for (i = 0; line[i]; i++) {
+      drawChar(i * 6, j * 8, line[i], WHITE, BLACK, 1);
+    }
+  }
+  flush();
+  us = benchElapsedUs();
+  benchReport(name, displayBytes - bytes, us);
+}
+
+void benchText(void) {
+  fillScreen(BLACK);
+  flush();
+#ifdef SSD1351_GLYPH_CACHE
+  glyphCacheClear();
+  glyphCacheHits = glyphCacheMisses = 0;
+  benchMessage("drawChar x168, cold cache");
+  benchMessage("drawChar x168, warm cache");
+  Report("%-28s %8lu hits %8lu misses\n\r", "glyph cache",
+         glyphCacheHits, glyphCacheMisses);
+#else
+  benchMessage("drawChar x168");
+#endif
+}
+
+//*****************************************************************************
+// Scaled text: a clock readout filling the screen at sizes 1 to 4, plotted
+// a square per font bit as drawChar() used to, then opaque and transparent
+
+static void plotChar(int x, int y, unsigned char c, unsigned int color,
+                     unsigned int bg, unsigned char size) {
+  const unsigned char *glyph = getGlyph(c);
+  unsigned char line;
+  int i, j;
+
+  for (i = 0; i < 6; i++) {
+    line = (i < 5) ? glyph[i] : 0;
+    for (j = 0; j < 8; j++) {
+      if ((line >> j) & 0x1) {
+        fillRect(x + i*size, y + j*size, size, size, color);
+      } else if (bg != color) {
+        fillRect(x + i*size, y + j*size, size, size, bg);
+      }
+    }
+  }
+}
+
+void benchTextSizes(void) {
+  static const char digits[] = "12:34:56";
+  static const char *names[] = { "per bit", "opaque", "transparent" };
+  char name[32];
+  unsigned long bytes;
+  unsigned long us;
+  int size, pass, x, y, i;
+
+  for (size = 1; size <= 4; size++) {
+    for (pass = 0; pass < 3; pass++) {
+      fillScreen(BLACK);
+      flush();
+
+      bytes = displayBytes;
+      benchStart();
+      for (y = 0; y + 8*size <= SSD1351HEIGHT; y += 8*size) {
+        for (x = 0, i = 0; x + 6*size <= SSD1351WIDTH; x += 6*size, i++) {
+          if (pass == 0) {
+            plotChar(x, y, digits[i % 8], GREEN, BLACK, size);
+          } else {
+            drawChar(x, y, digits[i % 8], GREEN, (pass == 1) ? BLACK : GREEN, size);
+          }
+        }
+      }
+      flush();
+      us = benchElapsedUs();
+
+      sprintf(name, "text size %d, %s", size, names[pass]);
+      benchReport(name, displayBytes - bytes, us);
+    }
+  }
+}
+
+//*****************************************************************************
+// Lines: the four corner fans of testlines(), plotted a pixel at a time as
+// drawLine() used to, then as runs by drawLine()
+
+static void plotLine(int x0, int y0, int x1, int y1, unsigned int color) {
+  int steep = abs(y1 - y0) > abs(x1 - x0);
+  int dx, dy, err, ystep;
+
+  if (steep) {
+    swap(x0, y0);
+    swap(x1, y1);
+  }
+  if (x0 > x1) {
+    swap(x0, x1);
+    swap(y0, y1);
+  }
+
+  dx = x1 - x0;
+  dy = abs(y1 - y0);
+  err = dx / 2;
+  ystep = (y0 < y1) ? 1 : -1;
+
+  for (; x0 <= x1; x0++) {
+    if (steep) {
+      drawPixel(y0, x0, color);
+    } else {
+      drawPixel(x0, y0, color);
+    }
+    err -= dy;
+    if (err < 0) {
+      y0 += ystep;
+      err += dx;
+    }
+  }
+}
+
+static void lineFans(const char *name,
+                     void (*line)(int, int, int, int, unsigned int)) {
+  unsigned long bytes;
+  unsigned long us;
+  int i;
+
+  fillScreen(BLACK);
+  flush();
+
+  bytes = displayBytes;
+  benchStart();
+  for (i = 0; i < SSD1351WIDTH - 1; i += 6) {
+    line(0, 0, i, SSD1351HEIGHT - 1, YELLOW);
+    line(0, 0, SSD1351WIDTH - 1, i, YELLOW);
+    line(SSD1351WIDTH - 1, 0, i, SSD1351HEIGHT - 1, YELLOW);
+    line(SSD1351WIDTH - 1, 0, 0, i, YELLOW);
+    line(0, SSD1351HEIGHT - 1, i, 0, YELLOW);
+    line(0, SSD1351HEIGHT - 1, SSD1351WIDTH - 1, i, YELLOW);
+    line(SSD1351WIDTH - 1, SSD1351HEIGHT - 1, i, 0, YELLOW);
+    line(SSD1351WIDTH - 1, SSD1351HEIGHT - 1, 0, i, YELLOW);
+  }
+  flush();
+  us = benchElapsedUs();
+  benchReport(name, displayBytes - bytes, us);
+}
+
+void benchLines(void) {
+  lineFans("line fans, per pixel", plotLine);
+  lineFans("line fans, runs", drawLine);
+}
+
+//*****************************************************************************
+// Outlines: the circle grid of testdrawcircles() without its delays, and
+// testroundrects()
+void benchOutlines(void) {
+  unsigned long bytes;
+  unsigned long us;
+  int x, y;
+
+  fillScreen(BLACK);
+  flush();
+
+  bytes = displayBytes;
+  benchStart();
+  for (x = 0; x < SSD1351WIDTH - 1 + 10; x += 20) {
+    for (y = 0; y < SSD1351HEIGHT - 1 + 10; y += 20) {
+      drawCircle(x, y, 10, WHITE);
+    }
+  }
+  flush();
+  us = benchElapsedUs();
+  benchReport("drawCircle grid, r 10", displayBytes - bytes, us);
+
+  bytes = displayBytes;
+  benchStart();
+  testroundrects();
+  flush();
+  us = benchElapsedUs();
+  benchReport("testroundrects", displayBytes - bytes, us);
+}
+
+//*****************************************************************************
+// Filled shapes: a gauge needle swept across the top of the screen, drawn
+// as a triangle and then as a thick line, each erased before the next step
+void benchShapes(void) {
+  unsigned long bytes;
+  unsigned long us;
+  int x;
+
+  fillScreen(BLACK);
+  flush();
+
+  bytes = displayBytes;
+  benchStart();
+  for (x = 8; x < SSD1351WIDTH - 8; x += 4) {
+    fillTriangle(60, 110, 68, 110, x, 16, RED);
+    fillTriangle(60, 110, 68, 110, x, 16, BLACK);
+  }
+  flush();
+  us = benchElapsedUs();
+  benchReport("fillTriangle needle sweep", displayBytes - bytes, us);
+
+  bytes = displayBytes;
+  benchStart();
+  for (x = 8; x < SSD1351WIDTH - 8; x += 4) {
+    drawThickLine(64, 110, x, 16, 5, RED);
+    drawThickLine(64, 110, x, 16, 5, BLACK);
+  }
+  flush();
+  us = benchElapsedUs();
+  benchReport("drawThickLine needle sweep", displayBytes - bytes, us);
+}
+
+//*****************************************************************************
+// 1-bit bitmaps: a 64x64 ring pattern tiled over the screen, drawn per pixel
+// as the old drawBitmap() did, then opaque and transparent
+
+#define ICON_SIZE  64
+
+static unsigned char icon[ICON_SIZE * ICON_SIZE / 8];
+
+static void makeIcon(void) {
+  int i, j, dx, dy;
+
+  memset(icon, 0, sizeof(icon));
+  for (j = 0; j < ICON_SIZE; j++) {
+    for (i = 0; i < ICON_SIZE; i++) {
+      dx = i - ICON_SIZE / 2;
+      dy = j - ICON_SIZE / 2;
+      if (((dx * dx + dy * dy) >> 6) & 0x1) {
+        icon[j * (ICON_SIZE / 8) + i / 8] |= 0x80 >> (i & 7);
+      }
+    }
+  }
+}
+
+static void plotIcon(int x, int y) {
+  int i, j;
+
+  for (j = 0; j < ICON_SIZE; j++) {
+    for (i = 0; i < ICON_SIZE; i++) {
+      if (icon[j * (ICON_SIZE / 8) + i / 8] & (0x80 >> (i & 7))) {
+        drawPixel(x + i, y + j, WHITE);
+      } else {
+        drawPixel(x + i, y + j, BLUE);
+      }
+    }
+  }
+}
+
+void benchBitmaps(void) {
+  unsigned long bytes;
+  unsigned long us;
+  int x, y, pass;
+  static const char *names[] = {
+    "bitmap tiles, per pixel", "bitmap tiles, opaque", "bitmap tiles, transparent"
+  };
+
+  makeIcon();
+  for (pass = 0; pass < 3; pass++) {
+    fillScreen(BLACK);
+    flush();
+
+    bytes = displayBytes;
+    benchStart();
+    for (y = 0; y < SSD1351HEIGHT; y += ICON_SIZE) {
+      for (x = 0; x < SSD1351WIDTH; x += ICON_SIZE) {
+        if (pass == 0) plotIcon(x, y);
+        else if (pass == 1) drawBitmapBg(x, y, icon, ICON_SIZE, ICON_SIZE, WHITE, BLUE);
+        else drawBitmap(x, y, icon, ICON_SIZE, ICON_SIZE, WHITE);
+      }
+    }
+    flush();
+    us = benchElapsedUs();
+    benchReport(names[pass], displayBytes - bytes, us);
+  }
+}
+
+//*****************************************************************************
+// SPI link tuner
+//
+// Times a full-screen fill for each link mode at every bit rate up to the
+// SSD1351 limit, then keeps the fastest combination. Rates that come within
+// LINK_TUNE_MARGIN percent of the best throughput count as a tie and the
+// lowest such rate wins, since a slower clock leaves more signal margin on
+// long jumper wires. Returns the chosen bit rate; the mode stays applied.
+
+#define LINK_TUNE_MARGIN  5
+
+// GSPI divides its 80 MHz clock; all of these are within SSD1351_MAX_BIT_RATE
+static const unsigned long linkRates[] = {
+  1000000, 2000000, 4000000, 8000000, 10000000, 13333333, 20000000
+};
+#define LINK_RATES  (sizeof(linkRates) / sizeof(linkRates[0]))
+
+static const char *const linkNames[] = { "8-bit", "16-bit", "32-bit" };
+
+unsigned long benchLink(void) {
+  unsigned long pixels = (unsigned long)SSD1351WIDTH * SSD1351HEIGHT;
+  unsigned long rate[3][LINK_RATES];
+  unsigned long best = 0, bestRate = 0, bestPixels = 0;
+  int bestMode = SSD1351_LINK_BYTE;
+  char name[32];
+  unsigned long us;
+  unsigned int i;
+  int mode;
+
+  for (mode = SSD1351_LINK_BYTE; mode <= SSD1351_LINK_WORD32; mode++) {
+    setLinkMode(mode);
+    for (i = 0; i < LINK_RATES; i++) {
+      setLinkBitRate(linkRates[i]);
+      benchStart();
+      fillScreen(BLACK);
+      flush();
+      us = benchElapsedUs();
+
+      rate[mode][i] = 0;
+      if (us > 0) {
+        rate[mode][i] = (unsigned long)(((unsigned long long)pixels * 1000000UL) / us);
+      }
+      if (rate[mode][i] > best) best = rate[mode][i];
+
+      sprintf(name, "%s link, %lu kHz", linkNames[mode], linkRates[i] / 1000);
+      benchReport(name, FULL_SCREEN_BYTES, us);
+    }
+  }
+
+  // lowest rate, then simplest mode, within the margin of the best
+  for (i = 0; i < LINK_RATES && bestRate == 0; i++) {
+    for (mode = SSD1351_LINK_BYTE; mode <= SSD1351_LINK_WORD32 && bestRate == 0; mode++) {
+      if (rate[mode][i] * 100 >= best * (100 - LINK_TUNE_MARGIN)) {
+        bestRate = linkRates[i];
+        bestMode = mode;
+        bestPixels = rate[mode][i];
+      }
+    }
+  }
+
+  setLinkMode(bestMode);
+  setLinkBitRate(bestRate);
+  Report("link: %s at %lu kHz, %lu px/s\n\r", linkNames[bestMode],
+         bestRate / 1000, bestPixels);
+  return bestRate;
+}
+
+#ifdef SSD1351_BANDED
+//*****************************************************************************
+// A chat-style screen: clear, two text rows, a divider and a few shapes
+static void benchScene(void) {
+  static const char line1[] = "The quick brown fox";
+  static const char line2[] = "jumps over the dog";
+  int i;
+
+  fillScreen(BLACK);
+  for (i = 0; line1[i]; i++) {
+    drawChar(i * 6, 12, line1[i], WHITE, BLACK, 1);
+  }
+  drawFastHLine(0, 63, SSD1351WIDTH, WHITE);
+  for (i = 0; line2[i]; i++) {
+    drawChar(i * 6, 82, line2[i], YELLOW, BLACK, 1);
+  }
+  fillRect(8, 30, 40, 20, BLUE);
+  fillCircle(90, 40, 12, RED);
+  drawLine(0, 100, 127, 127, GREEN);
+  flush();
+}
+
+// Draw the scene directly and with every band height the buffer allows
+void benchBands(void) {
+  static const int rows[] = { 0, 2, 4, 8, 16, 32 };
+  int saved = bandGetRows();
+  char name[32];
+  unsigned long bytes;
+  unsigned long us;
+  int i;
+
+  for (i = 0; i < (int)(sizeof(rows) / sizeof(rows[0])); i++) {
+    if (rows[i] > SSD1351_BAND_ROWS) continue;
+
+    bandSetRows(rows[i]);
+    bytes = displayBytes;
+    benchStart();
+    benchScene();
+    us = benchElapsedUs();
+
+    if (rows[i] == 0) {
+      strcpy(name, "scene, direct");
+    } else {
+      sprintf(name, "scene, %d-row bands", rows[i]);
+    }
+    benchReport(name, displayBytes - bytes, us);
+  }
+
+  bandSetRows(saved);
+  fillScreen(BLACK);
+  flush();
+}
+#endif
+
+//*****************************************************************************
+void benchDisplay(void) {
+#ifdef SSD1351_3WIRE
+  Report("\n\rSSD1351 benchmarks, 3-wire 9-bit\n\r");
+#else
+  Report("\n\rSSD1351 benchmarks, 4-wire\n\r");
+#endif
+  benchBoot();
+  benchFillScreen();
+  benchPixels();
+  benchText();
+  benchTextSizes();
+  benchLines();
+  benchOutlines();
+  benchShapes();
+  benchBitmaps();
+  benchCanvas();
+  benchLink();
+#ifdef SSD1351_BANDED
+  benchBands();
+#endif
+
+  Report("%-28s %8lu bytes\n\r", "window commands elided", displayElidedBytes);
+}
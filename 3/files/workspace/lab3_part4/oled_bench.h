@@ -0,0 +1,33 @@
+/*
+ * oled_bench.h
+ *
+ *  Throughput benchmarks for the SSD1351 driver. Results are printed
+ *  over UART with Report().
+ */
+
+#ifndef OLED_OLED_BENCH_H_
+#define OLED_OLED_BENCH_H_
+
+// Stopwatch on a free-running GPT (TIMERA2), 80 MHz ticks
+void benchStart(void);
+unsigned long benchElapsedUs(void);
+void benchReport(const char *name, unsigned long bytes, unsigned long us);
+
+void benchBoot(void);
+void benchFillScreen(void);
+void benchPixels(void);
+void benchText(void);
+void benchTextSizes(void);
+void benchLines(void);
+void benchOutlines(void);
+void benchShapes(void);
+void benchBitmaps(void);
+
+// C free functions against the C++ canvas (oled_canvas_bench.cpp)
+void benchCanvas(void);
+unsigned long benchLink(void);
+void benchBands(void);
+void benchDisplay(void);
+
+
+#endif /* OLED_OLED_BENCH_H_ */
@@ -0,0 +1,588 @@
+/*
+ * oled_canvas.h
+ *
+ *  Header-only C++ drawing canvas. The backend is a template parameter
+ *  (CRTP), so the pixel and span writers inline into every primitive with
+ *  no virtual calls or function pointers:
+ *
+ *    Ssd1351Canvas          straight to the panel
+ *    FramebufferCanvas<W,H> RAM copy, sent to the panel by flush()
+ *    PpmCanvas<W,H>         RAM copy, written to a PPM file (host builds)
+ *
+ *  A backend provides beginDraw()/endDraw() around a batch of writes,
+ *  writePixel(x, y, c), setWindow(x, y, w, h) and writeColor(c, n) /
+ *  writePixels(p, n) to fill the window row by row. The canvas clips
+ *  everything first, so backends never see coordinates off the screen.
+ *  The primitives use the same algorithms as Adafruit_GFX.c, drawing the
+ *  same spans: run-slice lines, outline runs and column spans for circles,
+ *  edge walkers started on the first visible row for triangles, and glyph
+ *  windows for opaque text, with the font and circle spans taken from the
+ *  C side. A benchmark of the two therefore measures the dispatch, not the
+ *  drawing.
+ */
+
+#ifndef OLED_OLED_CANVAS_H_
+#define OLED_OLED_CANVAS_H_
+
+#ifndef __cplusplus
+#error "oled_canvas.h is C++ only; C code uses Adafruit_GFX.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+extern "C" {
+#include "Adafruit_GFX.h"
+#include "Adafruit_SSD1351.h"
+}
+
+namespace oled {
+
+template <class Backend>
+class Canvas {
+ public:
+  Canvas(int w, int h) : _width(w), _height(h) {
+    clearClipRect();
+  }
+
+  int width(void) const { return _width; }
+  int height(void) const { return _height; }
+
+  void setClipRect(int x, int y, int w, int h) {
+    _clipX0 = (x < 0) ? 0 : x;
+    _clipY0 = (y < 0) ? 0 : y;
+    _clipX1 = (x + w > _width) ? _width : x + w;
+    _clipY1 = (y + h > _height) ? _height : y + h;
+    if (_clipX1 < _clipX0) _clipX1 = _clipX0;
+    if (_clipY1 < _clipY0) _clipY1 = _clipY0;
+  }
+
+  void clearClipRect(void) {
+    setClipRect(0, 0, _width, _height);
+  }
+
+  void drawPixel(int x, int y, unsigned int color) {
+    if (x < _clipX0 || x >= _clipX1 || y < _clipY0 || y >= _clipY1) return;
+    Batch b(self());
+    self().writePixel(x, y, color);
+  }
+
+  void fillRect(int x, int y, int w, int h, unsigned int color) {
+    if (!clip(x, y, w, h)) return;
+    Batch b(self());
+    self().setWindow(x, y, w, h);
+    self().writeColor(color, (unsigned long)w * h);
+  }
+
+  void drawFastHLine(int x, int y, int w, unsigned int color) {
+    fillRect(x, y, w, 1, color);
+  }
+
+  void drawFastVLine(int x, int y, int h, unsigned int color) {
+    fillRect(x, y, 1, h, color);
+  }
+
+  void fillScreen(unsigned int color) {
+    fillRect(0, 0, _width, _height, color);
+  }
+
+  void drawRect(int x, int y, int w, int h, unsigned int color) {
+    drawFastHLine(x, y, w, color);
+    drawFastHLine(x, y + h - 1, w, color);
+    drawFastVLine(x, y, h, color);
+    drawFastVLine(x + w - 1, y, h, color);
+  }
+
+  // Run-slice Bresenham: each run along the major axis is one span
+  void drawLine(int x0, int y0, int x1, int y1, unsigned int color) {
+    int steep = abs(y1 - y0) > abs(x1 - x0);
+    int dx, dy, err, ystep, run;
+
+    if (rejects(min(x0, x1), min(y0, y1), max(x0, x1), max(y0, y1))) return;
+
+    if (steep) {
+      exchange(x0, y0);
+      exchange(x1, y1);
+    }
+    if (x0 > x1) {
+      exchange(x0, x1);
+      exchange(y0, y1);
+    }
+
+    dx = x1 - x0;
+    dy = abs(y1 - y0);
+    err = dx / 2;
+    ystep = (y0 < y1) ? 1 : -1;
+
+    while (x0 <= x1) {
+      run = (dy == 0) ? x1 - x0 + 1 : err / dy + 1;
+      if (run > x1 - x0 + 1) run = x1 - x0 + 1;
+
+      if (run == 1) {
+        drawPixel(steep ? y0 : x0, steep ? x0 : y0, color);
+      } else if (steep) {
+        fillRect(y0, x0, 1, run, color);
+      } else {
+        fillRect(x0, y0, run, 1, color);
+      }
+
+      x0 += run;
+      err -= run * dy;
+      if (err < 0) {
+        y0 += ystep;
+        err += dx;
+      }
+    }
+  }
+
+  // Outline as runs: octant points that share a row are one horizontal
+  // span, and the same run transposed is a vertical span
+  void drawCircle(int x0, int y0, int r, unsigned int color) {
+    int f = 1 - r, ddF_x = 1, ddF_y = -2 * r, x = 0, y = r;
+    int runStart = 0, runY = r;
+
+    if (rejects(x0 - r, y0 - r, x0 + r, y0 + r)) return;
+
+    Batch b(self());
+    while (x < y) {
+      if (f >= 0) {
+        y--;
+        ddF_y += 2;
+        f += ddF_y;
+      }
+      x++;
+      ddF_x += 2;
+      f += ddF_x;
+
+      if (runStart >= 0 && y != runY) {
+        outlineRun(x0, y0, runStart, x - 1, runY, color);
+        runStart = -1;
+      }
+      if (runStart < 0) {
+        runStart = x;
+        runY = y;
+      }
+    }
+    if (runStart >= 0) outlineRun(x0, y0, runStart, x, runY, color);
+  }
+
+  // One rectangle per run of columns with the same half-height, the center
+  // run joining both sides
+  void fillCircle(int x0, int y0, int r, unsigned int color) {
+    unsigned char buf[SSD1351WIDTH];
+    const unsigned char *spans;
+    int a, b, h;
+
+    if (rejects(x0 - r, y0 - r, x0 + r, y0 + r)) return;
+    if (r < 0 || r >= SSD1351WIDTH) {
+      fillCircleColumns(x0, y0, r, color);
+      return;
+    }
+
+    spans = getCircleSpans(r, buf);
+    for (a = 0; a <= r; a = b + 1) {
+      h = spans[a];
+      for (b = a; b < r && spans[b + 1] == h; b++) ;
+
+      if (a == 0) {
+        fillRect(x0 - b, y0 - h, 2 * b + 1, 2 * h + 1, color);
+      } else {
+        fillRect(x0 + a, y0 - h, b - a + 1, 2 * h + 1, color);
+        fillRect(x0 - b, y0 - h, b - a + 1, 2 * h + 1, color);
+      }
+    }
+  }
+
+  void drawTriangle(int x0, int y0, int x1, int y1, int x2, int y2,
+                    unsigned int color) {
+    drawLine(x0, y0, x1, y1, color);
+    drawLine(x1, y1, x2, y2, color);
+    drawLine(x2, y2, x0, y0, color);
+  }
+
+  // Edge walker: x steps by a whole part and a remainder over dy
+  void fillTriangle(int x0, int y0, int x1, int y1, int x2, int y2,
+                    unsigned int color) {
+    Edge e01, e02, e12;
+    int y, last;
+
+    if (y0 > y1) { exchange(y0, y1); exchange(x0, x1); }
+    if (y1 > y2) { exchange(y2, y1); exchange(x2, x1); }
+    if (y0 > y1) { exchange(y0, y1); exchange(x0, x1); }
+
+    if (rejects(min(x0, min(x1, x2)), y0, max(x0, max(x1, x2)), y2)) return;
+
+    Batch b(self());
+    if (y0 == y2) {
+      row(min(x0, min(x1, x2)), max(x0, max(x1, x2)), y0, color);
+      return;
+    }
+
+    last = (y1 == y2) ? y1 : y1 - 1;
+    y = max(y0, _clipY0);
+    e02.start(x0, y0, x2, y2, y - y0);
+    if (y <= last) e01.start(x0, y0, x1, y1, y - y0);
+    for (; y <= last && y < _clipY1; y++) {
+      row(e01.x(), e02.x(), y, color);
+      e01.next();
+      e02.next();
+    }
+
+    if (y1 < y2 && y < _clipY1) {
+      e12.start(x1, y1, x2, y2, y - y1);
+      for (; y <= y2 && y < _clipY1; y++) {
+        row(e12.x(), e02.x(), y, color);
+        e12.next();
+        e02.next();
+      }
+    }
+  }
+
+  // 5x7 font glyph scaled by size; opaque when bg differs from color
+  void drawChar(int x, int y, unsigned char c, unsigned int color,
+                unsigned int bg, unsigned char size) {
+    const unsigned char *glyph = getGlyph(c);
+    unsigned char cols[6];
+
+    if (rejects(x, y, x + 6 * size - 1, y + 8 * size - 1)) return;
+
+    for (int i = 0; i < 5; i++) cols[i] = glyph[i];
+    cols[5] = 0;
+
+    if (bg != color) {
+      glyphWindow(x, y, cols, 1, color, bg, size);
+      return;
+    }
+
+    Batch b(self());
+
+    // one rectangle per vertical run, widened over the columns to its
+    // right that have exactly the same run
+    for (int i = 0; i < 5; i++) {
+      for (int j = 0; j < 8; j++) {
+        if (!((cols[i] >> j) & 0x1)) continue;
+        int top = j;
+        while (j < 7 && ((cols[i] >> (j + 1)) & 0x1)) j++;
+
+        unsigned char run = (0xFF >> (7 - j)) & (0xFF << top);
+        unsigned char edges = run | (run << 1) | (run >> 1);
+        int w = 1;
+        for (; i + w < 5 && (cols[i + w] & edges) == run; w++) {
+          cols[i + w] &= ~run;
+        }
+        fillRect(x + i * size, y + top * size, w * size, (j - top + 1) * size,
+                 color);
+      }
+    }
+  }
+
+  // Opaque text goes out as one window per panel width of glyphs
+  void print(int x, int y, const char *s, unsigned int color,
+             unsigned int bg, unsigned char size) {
+    unsigned char cols[SSD1351WIDTH];
+    int n;
+
+    if (bg == color) {
+      for (; *s; s++, x += 6 * size) {
+        drawChar(x, y, *s, color, bg, size);
+      }
+      return;
+    }
+
+    for (; *s; s += n, x += 6 * n * size) {
+      for (n = 0; s[n] && n < SSD1351WIDTH / 6; n++) {
+        const unsigned char *glyph = getGlyph(s[n]);
+
+        for (int k = 0; k < 5; k++) cols[6 * n + k] = glyph[k];
+        cols[6 * n + 5] = 0;
+      }
+      if (rejects(x, y, x + 6 * n * size - 1, y + 8 * size - 1)) continue;
+      glyphWindow(x, y, cols, n, color, bg, size);
+    }
+  }
+
+ protected:
+  Backend &self(void) { return *static_cast<Backend *>(this); }
+
+  // beginDraw()/endDraw() around a primitive; they nest
+  struct Batch {
+    Backend &_b;
+    explicit Batch(Backend &b) : _b(b) { _b.beginDraw(); }
+    ~Batch() { _b.endDraw(); }
+  };
+
+  struct Edge {
+    int _x0, _sign, _dy, _whole, _frac, _q, _rem;
+
+    // positioned k rows below y0
+    void start(int x0, int y0, int x1, int y1, int k) {
+      int adx = abs(x1 - x0);
+      _x0 = x0;
+      _sign = (x1 < x0) ? -1 : 1;
+      _dy = y1 - y0;
+      _whole = adx / _dy;
+      _frac = adx % _dy;
+      _q = _whole * k + (_frac * k) / _dy;
+      _rem = (_frac * k) % _dy;
+    }
+    int x(void) const { return _x0 + _sign * _q; }
+    void next(void) {
+      _q += _whole;
+      _rem += _frac;
+      if (_rem >= _dy) {
+        _rem -= _dy;
+        _q++;
+      }
+    }
+  };
+
+  // Span from (x0, y0) to (x1, y1) along a row or a column
+  void span(int x0, int y0, int x1, int y1, unsigned int color) {
+    if (x0 == x1 && y0 == y1) {
+      drawPixel(x0, y0, color);
+    } else {
+      fillRect(x0, y0, x1 - x0 + 1, y1 - y0 + 1, color);
+    }
+  }
+
+  // The run x = a..b at height y and its transpose, in all four quadrants;
+  // a run that starts on an axis is joined with its mirror image
+  void outlineRun(int x0, int y0, int a, int b, int y, unsigned int color) {
+    if (a == 0) {
+      span(x0 - b, y0 - y, x0 + b, y0 - y, color);
+      span(x0 - b, y0 + y, x0 + b, y0 + y, color);
+      span(x0 - y, y0 - b, x0 - y, y0 + b, color);
+      span(x0 + y, y0 - b, x0 + y, y0 + b, color);
+      return;
+    }
+    span(x0 - b, y0 - y, x0 - a, y0 - y, color);
+    span(x0 + a, y0 - y, x0 + b, y0 - y, color);
+    span(x0 - b, y0 + y, x0 - a, y0 + y, color);
+    span(x0 + a, y0 + y, x0 + b, y0 + y, color);
+    span(x0 - y, y0 - b, x0 - y, y0 - a, color);
+    span(x0 - y, y0 + a, x0 - y, y0 + b, color);
+    span(x0 + y, y0 - b, x0 + y, y0 - a, color);
+    span(x0 + y, y0 + a, x0 + y, y0 + b, color);
+  }
+
+  // Circles too big for a span table, one column at a time
+  void fillCircleColumns(int x0, int y0, int r, unsigned int color) {
+    int f = 1 - r, ddF_x = 1, ddF_y = -2 * r, x = 0, y = r;
+
+    drawFastVLine(x0, y0 - r, 2 * r + 1, color);
+    while (x < y) {
+      if (f >= 0) {
+        y--;
+        ddF_y += 2;
+        f += ddF_y;
+      }
+      x++;
+      ddF_x += 2;
+      f += ddF_x;
+
+      drawFastVLine(x0 + x, y0 - y, 2 * y + 1, color);
+      drawFastVLine(x0 + y, y0 - x, 2 * x + 1, color);
+      drawFastVLine(x0 - x, y0 - y, 2 * y + 1, color);
+      drawFastVLine(x0 - y, y0 - x, 2 * x + 1, color);
+    }
+  }
+
+  // Opaque glyphs: each of the 8 glyph rows is expanded once, scaled
+  // across, and sent size times into one window over the visible part,
+  // in strips no wider than the panel. cols holds 6 columns per glyph.
+  void glyphWindow(int x, int y, const unsigned char *cols, int n,
+                   unsigned int color, unsigned int bg, unsigned char size) {
+    unsigned short row[SSD1351WIDTH];
+    int x0 = max(x, _clipX0), x1 = min(x + 6 * n * size, _clipX1) - 1;
+    int y0 = max(y, _clipY0), y1 = min(y + 8 * size, _clipY1) - 1;
+
+    Batch b(self());
+    for (int sx = x0; sx <= x1; sx += SSD1351WIDTH) {
+      int w = min(x1 - sx + 1, SSD1351WIDTH);
+
+      self().setWindow(sx, y0, w, y1 - y0 + 1);
+      for (int j = 0; j < 8; j++) {
+        int top = max(y + j * size, y0);
+        int bottom = min(y + (j + 1) * size - 1, y1);
+        int gi = (sx - x) / size, rep = (sx - x) % size;
+
+        if (top > bottom) continue;
+        for (int px = 0; px < w; px++) {
+          row[px] = ((cols[gi] >> j) & 0x1) ? color : bg;
+          if (++rep == size) {
+            rep = 0;
+            gi++;
+          }
+        }
+        for (int r = top; r <= bottom; r++) {
+          self().writePixels(row, w);
+        }
+      }
+    }
+  }
+
+  void row(int a, int b, int y, unsigned int color) {
+    if (a > b) exchange(a, b);
+    fillRect(a, y, b - a + 1, 1, color);
+  }
+
+  bool clip(int &x, int &y, int &w, int &h) const {
+    if (x < _clipX0) { w -= _clipX0 - x; x = _clipX0; }
+    if (y < _clipY0) { h -= _clipY0 - y; y = _clipY0; }
+    if (x + w > _clipX1) w = _clipX1 - x;
+    if (y + h > _clipY1) h = _clipY1 - y;
+    return w > 0 && h > 0;
+  }
+
+  bool rejects(int x0, int y0, int x1, int y1) const {
+    return x1 < _clipX0 || x0 >= _clipX1 || y1 < _clipY0 || y0 >= _clipY1;
+  }
+
+  static int min(int a, int b) { return (a < b) ? a : b; }
+  static int max(int a, int b) { return (a > b) ? a : b; }
+  static void exchange(int &a, int &b) { int t = a; a = b; b = t; }
+
+  int _width, _height;
+  int _clipX0, _clipY0, _clipX1, _clipY1;
+};
+
+//*****************************************************************************
+// Direct to the panel through the driver's transactions and window shadow
+class Ssd1351Canvas : public Canvas<Ssd1351Canvas> {
+ public:
+  Ssd1351Canvas() : Canvas<Ssd1351Canvas>(SSD1351WIDTH, SSD1351HEIGHT) {}
+
+  void beginDraw(void) { startWrite(); }
+  void endDraw(void) { endWrite(); }
+
+  void writePixel(int x, int y, unsigned int color) {
+    ::setPixelWindow(x, y);
+    sendColor(color, 1);
+  }
+  void setWindow(int x, int y, int w, int h) {
+    ::setWindow(x, y, x + w - 1, y + h - 1);
+  }
+  void writeColor(unsigned int color, unsigned long n) {
+    sendColor(color, n);
+  }
+  void writePixels(const unsigned short *pixels, unsigned long n) {
+    sendPixels(pixels, n);
+  }
+};
+
+//*****************************************************************************
+// Drawing into a W x H RAM image; the window is followed with a cursor
+template <int W, int H, class Derived>
+class RamCanvas : public Canvas<Derived> {
+ public:
+  RamCanvas() : Canvas<Derived>(W, H) {
+    markClean();
+  }
+
+  void beginDraw(void) {}
+  void endDraw(void) {}
+
+  void writePixel(int x, int y, unsigned int color) {
+    _pixels[y * W + x] = color;
+    markDirty(x, y, x, y);
+  }
+  void setWindow(int x, int y, int w, int h) {
+    _wx0 = _cx = x;
+    _wx1 = x + w - 1;
+    _cy = y;
+    markDirty(x, y, x + w - 1, y + h - 1);
+  }
+  void writeColor(unsigned int color, unsigned long n) {
+    while (n > 0) {
+      unsigned short *p = &_pixels[_cy * W + _cx];
+      unsigned long run = _wx1 - _cx + 1;
+
+      if (run > n) run = n;
+      n -= run;
+      advance(run);
+      while (run--) *p++ = color;
+    }
+  }
+  void writePixels(const unsigned short *pixels, unsigned long n) {
+    while (n > 0) {
+      unsigned short *p = &_pixels[_cy * W + _cx];
+      unsigned long run = _wx1 - _cx + 1;
+
+      if (run > n) run = n;
+      n -= run;
+      advance(run);
+      while (run--) *p++ = *pixels++;
+    }
+  }
+
+  const unsigned short *pixels(void) const { return _pixels; }
+
+ protected:
+  void advance(unsigned long run) {
+    _cx += run;
+    if (_cx > _wx1) {
+      _cx = _wx0;
+      _cy++;
+    }
+  }
+
+  void markClean(void) {
+    _dx0 = W;
+    _dy0 = H;
+    _dx1 = _dy1 = -1;
+  }
+  void markDirty(int x0, int y0, int x1, int y1) {
+    if (x0 < _dx0) _dx0 = x0;
+    if (y0 < _dy0) _dy0 = y0;
+    if (x1 > _dx1) _dx1 = x1;
+    if (y1 > _dy1) _dy1 = y1;
+  }
+
+  unsigned short _pixels[W * H];
+  int _wx0, _wx1, _cx, _cy;
+  int _dx0, _dy0, _dx1, _dy1;   // dirty box, inclusive
+};
+
+// RAM copy sent to the panel by flush(), dirty box only
+template <int W = SSD1351WIDTH, int H = SSD1351HEIGHT>
+class FramebufferCanvas : public RamCanvas<W, H, FramebufferCanvas<W, H> > {
+ public:
+  void flush(void) {
+    int w = this->_dx1 - this->_dx0 + 1;
+
+    if (this->_dx1 < this->_dx0) return;
+
+    startWrite();
+    ::setWindow(this->_dx0, this->_dy0, this->_dx1, this->_dy1);
+    for (int y = this->_dy0; y <= this->_dy1; y++) {
+      sendPixels(&this->_pixels[y * W + this->_dx0], w);
+    }
+    endWrite();
+    this->markClean();
+  }
+};
+
+// RAM copy written out as a binary PPM, for checking drawing on a host
+template <int W = SSD1351WIDTH, int H = SSD1351HEIGHT>
+class PpmCanvas : public RamCanvas<W, H, PpmCanvas<W, H> > {
+ public:
+  // Returns 0 if the file could not be written
+  int save(const char *path) const {
+    FILE *f = fopen(path, "wb");
+
+    if (!f) return 0;
+    fprintf(f, "P6 %d %d 255\n", W, H);
+    for (int i = 0; i < W * H; i++) {
+      unsigned short c = this->_pixels[i];
+
+      fputc((c >> 11) << 3, f);
+      fputc(((c >> 5) & 0x3F) << 2, f);
+      fputc((c & 0x1F) << 3, f);
+    }
+    return fclose(f) == 0;
+  }
+};
+
+}  // namespace oled
+
+#endif /* OLED_OLED_CANVAS_H_ */
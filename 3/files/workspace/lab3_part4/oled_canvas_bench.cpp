@@ -0,0 +1,116 @@
+/*
+ * oled_canvas_bench.cpp
+ *
+ *  Runs the same drawing through the C free functions and through
+ *  oled::Ssd1351Canvas, and reports both with benchReport(). Both sides
+ *  use the same algorithms and send the same spans, so the difference is
+ *  the cost of the calls. The canvas always draws straight to the panel,
+ *  so compare it with the C functions in a build without
+ *  SSD1351_FRAMEBUFFER or SSD1351_BANDED.
+ */
+
+extern "C" {
+#include "Adafruit_GFX.h"
+#include "Adafruit_SSD1351.h"
+#include "oled_test.h"
+#include "oled_bench.h"
+}
+#include "oled_canvas.h"
+
+static oled::Ssd1351Canvas canvas;
+
+static const char message[] = "hello from the cc3200";
+
+//*****************************************************************************
+// Workloads, once for each side
+
+static void cLines(void) {
+  for (int i = 0; i < SSD1351WIDTH - 1; i += 6) {
+    drawLine(0, 0, i, SSD1351HEIGHT - 1, YELLOW);
+    drawLine(0, 0, SSD1351WIDTH - 1, i, YELLOW);
+    drawLine(SSD1351WIDTH - 1, SSD1351HEIGHT - 1, i, 0, YELLOW);
+    drawLine(SSD1351WIDTH - 1, SSD1351HEIGHT - 1, 0, i, YELLOW);
+  }
+}
+
+static void canvasLines(void) {
+  for (int i = 0; i < SSD1351WIDTH - 1; i += 6) {
+    canvas.drawLine(0, 0, i, SSD1351HEIGHT - 1, YELLOW);
+    canvas.drawLine(0, 0, SSD1351WIDTH - 1, i, YELLOW);
+    canvas.drawLine(SSD1351WIDTH - 1, SSD1351HEIGHT - 1, i, 0, YELLOW);
+    canvas.drawLine(SSD1351WIDTH - 1, SSD1351HEIGHT - 1, 0, i, YELLOW);
+  }
+}
+
+static void cCircles(void) {
+  for (int x = 10; x < SSD1351WIDTH; x += 24) {
+    for (int y = 10; y < SSD1351HEIGHT; y += 24) {
+      fillCircle(x, y, 10, BLUE);
+      drawCircle(x, y, 10, WHITE);
+    }
+  }
+}
+
+static void canvasCircles(void) {
+  for (int x = 10; x < SSD1351WIDTH; x += 24) {
+    for (int y = 10; y < SSD1351HEIGHT; y += 24) {
+      canvas.fillCircle(x, y, 10, BLUE);
+      canvas.drawCircle(x, y, 10, WHITE);
+    }
+  }
+}
+
+static void cTriangles(void) {
+  for (int x = 8; x < SSD1351WIDTH - 8; x += 4) {
+    fillTriangle(60, 110, 68, 110, x, 16, RED);
+    fillTriangle(60, 110, 68, 110, x, 16, BLACK);
+  }
+}
+
+static void canvasTriangles(void) {
+  for (int x = 8; x < SSD1351WIDTH - 8; x += 4) {
+    canvas.fillTriangle(60, 110, 68, 110, x, 16, RED);
+    canvas.fillTriangle(60, 110, 68, 110, x, 16, BLACK);
+  }
+}
+
+static void cText(void) {
+  for (int line = 0; line < 8; line++) {
+    drawGlyphRun(0, line * 8, (const unsigned char *)message,
+                 sizeof(message) - 1, WHITE, BLACK, 1);
+  }
+}
+
+static void canvasText(void) {
+  for (int line = 0; line < 8; line++) {
+    canvas.print(0, line * 8, message, WHITE, BLACK, 1);
+  }
+}
+
+//*****************************************************************************
+
+static void run(const char *name, void (*draw)(void)) {
+  unsigned long bytes;
+  unsigned long us;
+
+  fillScreen(BLACK);
+  flush();
+
+  bytes = displayBytes;
+  benchStart();
+  draw();
+  flush();
+  us = benchElapsedUs();
+  benchReport(name, displayBytes - bytes, us);
+}
+
+void benchCanvas(void) {
+  run("lines, C", cLines);
+  run("lines, canvas", canvasLines);
+  run("circles, C", cCircles);
+  run("circles, canvas", canvasCircles);
+  run("triangles, C", cTriangles);
+  run("triangles, canvas", canvasTriangles);
+  run("text, C", cText);
+  run("text, canvas", canvasText);
+}
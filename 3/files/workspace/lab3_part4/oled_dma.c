@@ -0,0 +1,213 @@
+/* Asynchronous pixel pump for the SSD1351.
+*
+*  A transfer opens a normal driver transaction, programs the RAM window,
+*  then switches GSPI to 16-bit transmit-only words and lets uDMA channel
+*  31 (GSPI TX) feed the TX register. uDMA moves at most 1024 items per
+*  request, so larger windows are sent in chunks re-armed from the GSPI
+*  DMA-done interrupt. When the last chunk drains the SPI is put back into
+*  its 8-bit configuration, CS is released and the caller's callback runs.
+*
+*  While a transfer is in flight displayBusy is set. The transfer holds one
+*  level of the driver's transaction depth until its interrupt closes it,
+*  and startWrite() waits on displayBusy at every depth, so a blocking draw
+*  issued meanwhile, even inside an open transaction, waits until the pump
+*  is finished.
+*
+*  With SSD1351_3WIRE each pixel is one 18-bit word instead, so fills
+*  repeat a 32-bit item and buffer pushes are sent synchronously.
+*/
+
+// Driverlib includes
+#include "hw_types.h"
+#include "hw_memmap.h"
+#include "hw_ints.h"
+#include "hw_mcspi.h"
+#include "spi.h"
+#include "udma.h"
+#include "rom.h"
+#include "rom_map.h"
+#include "interrupt.h"
+#include "prcm.h"
+
+// Common interface includes
+#include "udma_if.h"
+
+#include "Adafruit_SSD1351.h"
+#include "Adafruit_GFX.h"
+#include "oled_dma.h"
+
+
+#define DISPLAY_DMA_CHANNEL  UDMA_CH31_GSPI_TX
+#define DISPLAY_DMA_MAX_ITEMS  1024
+
+// CH0CONF.TRM = 2: transmit only, nothing is clocked into RX
+#define MCSPI_TRM_TX_ONLY  (2 << MCSPI_CH0CONF_TRM_S)
+
+
+#ifdef SSD1351_3WIRE
+// 3-wire pixels are 18-bit words; a fill repeats one precomputed word
+#define DMA_WL         SSD1351_WL_18
+#define DMA_ITEM_SIZE  UDMA_SIZE_32
+static volatile unsigned long dmaColor;
+#else
+#define DMA_WL         SPI_WL_16
+#define DMA_ITEM_SIZE  UDMA_SIZE_16
+static volatile unsigned short dmaColor;
+#endif
+static unsigned int dmaFillColor;
+static const unsigned short *volatile dmaSrc;
+static volatile unsigned long dmaRemaining;
+static volatile unsigned char dmaRepeat;
+static DisplayDoneCallback dmaDone;
+static unsigned long savedConf;
+
+
+// Word length and TRM can only be changed while the channel is disabled
+static void spiSetConf(unsigned long conf) {
+  MAP_SPIDisable(GSPI_BASE);
+  HWREG(GSPI_BASE + MCSPI_O_CH0CONF) = conf;
+  MAP_SPIEnable(GSPI_BASE);
+}
+
+static void startChunk(void) {
+  unsigned long n = dmaRemaining;
+
+  if (n > DISPLAY_DMA_MAX_ITEMS) n = DISPLAY_DMA_MAX_ITEMS;
+
+  if (dmaRepeat) {
+    UDMASetupTransfer(DISPLAY_DMA_CHANNEL, UDMA_MODE_BASIC, n, DMA_ITEM_SIZE,
+                      UDMA_ARB_1, (void *)&dmaColor, UDMA_SRC_INC_NONE,
+                      (void *)(GSPI_BASE + MCSPI_O_TX0), UDMA_DST_INC_NONE);
+  } else {
+    UDMASetupTransfer(DISPLAY_DMA_CHANNEL, UDMA_MODE_BASIC, n, UDMA_SIZE_16,
+                      UDMA_ARB_1, (void *)dmaSrc, UDMA_SRC_INC_16,
+                      (void *)(GSPI_BASE + MCSPI_O_TX0), UDMA_DST_INC_NONE);
+    dmaSrc += n;
+  }
+  dmaRemaining -= n;
+}
+
+static void finishTransfer(void) {
+  DisplayDoneCallback done = dmaDone;
+
+  // let the last word leave the shift register before CS goes high
+  while (!(HWREG(GSPI_BASE + MCSPI_O_CH0STAT) & MCSPI_CH0STAT_EOT));
+
+  MAP_SPIIntDisable(GSPI_BASE, SPI_INT_DMATX);
+  MAP_SPIDmaDisable(GSPI_BASE, SPI_TX_DMA);
+  spiSetConf(savedConf);
+
+  endWrite();
+  displayBusy = 0;
+
+  if (done) done();
+}
+
+static void displayDMAIntHandler(void) {
+  unsigned long status = MAP_SPIIntStatus(GSPI_BASE, true);
+  MAP_SPIIntClear(GSPI_BASE, status);
+
+  if (!(status & SPI_INT_DMATX)) return;
+  if (MAP_uDMAChannelIsEnabled(DISPLAY_DMA_CHANNEL)) return;
+
+  if (dmaRemaining > 0) {
+    startChunk();
+  } else {
+    finishTransfer();
+  }
+}
+
+static int startTransfer(int x, int y, int w, int h, DisplayDoneCallback done) {
+  unsigned long conf;
+
+  if ((x < 0) || (y < 0) || (w <= 0) || (h <= 0)) return 0;
+  if ((x + w > width()) || (y + h > height())) return 0;
+
+  // one transfer at a time; this also flushes any blocking writes
+  startWrite();
+  setWindow(x, y, x+w-1, y+h-1);
+
+  // a window split by hardware scrolling needs two address windows
+  if (windowSplit()) {
+    if (dmaRepeat) {
+      sendColor(dmaFillColor, (unsigned long)w * h);
+    } else {
+      sendPixels(dmaSrc, (unsigned long)w * h);
+    }
+    endWrite();
+    if (done) done();
+    return 1;
+  }
+  advanceWindow((unsigned long)w * h);
+
+  displayBusy = 1;
+  dmaDone = done;
+  dmaRemaining = (unsigned long)w * h;
+
+  savedConf = HWREG(GSPI_BASE + MCSPI_O_CH0CONF);
+  conf = savedConf & ~(MCSPI_CH0CONF_WL_M | MCSPI_CH0CONF_TRM_M |
+                       MCSPI_CH0CONF_FFEW);
+  spiSetConf(conf | DMA_WL | MCSPI_TRM_TX_ONLY);
+
+  MAP_SPIIntClear(GSPI_BASE, SPI_INT_DMATX);
+  MAP_SPIIntEnable(GSPI_BASE, SPI_INT_DMATX);
+  startChunk();
+  MAP_SPIDmaEnable(GSPI_BASE, SPI_TX_DMA);
+  return 1;
+}
+
+//*****************************************************************************
+
+void displayDMAInit(void) {
+  UDMAInit();
+  MAP_uDMAChannelAssign(DISPLAY_DMA_CHANNEL);
+  MAP_SPIIntRegister(GSPI_BASE, displayDMAIntHandler);
+}
+
+int fillRectAsync(int x, int y, int w, int h, unsigned int color,
+                  DisplayDoneCallback done) {
+  displayDMAWait();
+  dmaFillColor = color;
+#ifdef SSD1351_3WIRE
+  dmaColor = SSD1351_PIXEL_WORD(color);
+#else
+  dmaColor = color;
+#endif
+  dmaRepeat = 1;
+  return startTransfer(x, y, w, h, done);
+}
+
+int pushColorsAsync(int x, int y, int w, int h, const unsigned short *pixels,
+                    DisplayDoneCallback done) {
+  displayDMAWait();
+#ifdef SSD1351_3WIRE
+  // buffered pixels would need expanding to 18-bit words first, so send
+  // them synchronously and report completion right away
+  if ((x < 0) || (y < 0) || (w <= 0) || (h <= 0)) return 0;
+  if ((x + w > width()) || (y + h > height())) return 0;
+
+  startWrite();
+  setWindow(x, y, x+w-1, y+h-1);
+  sendPixels(pixels, (unsigned long)w * h);
+  endWrite();
+
+  if (done) done();
+  return 1;
+#else
+  dmaSrc = pixels;
+  dmaRepeat = 0;
+  return startTransfer(x, y, w, h, done);
+#endif
+}
+
+int fillScreenAsync(unsigned int color, DisplayDoneCallback done) {
+  return fillRectAsync(0, 0, width(), height(), color, done);
+}
+
+int displayDMABusy(void) {
+  return displayBusy;
+}
+
+void displayDMAWait(void) {
+  while (displayBusy);
+}
@@ -0,0 +1,28 @@
+/*
+ * oled_dma.h
+ *
+ *  Non-blocking pixel output for the SSD1351 using the CC3200 uDMA and
+ *  the GSPI transmit DMA request.
+ */
+
+#ifndef OLED_OLED_DMA_H_
+#define OLED_OLED_DMA_H_
+
+typedef void (*DisplayDoneCallback)(void);
+
+void displayDMAInit(void);
+
+// Start filling a window with a single color, or with w*h pixels from a
+// buffer that must stay valid until the transfer completes. Both return 0
+// if the window is empty or off screen, otherwise 1.
+int fillRectAsync(int x, int y, int w, int h, unsigned int color,
+                  DisplayDoneCallback done);
+int pushColorsAsync(int x, int y, int w, int h, const unsigned short *pixels,
+                    DisplayDoneCallback done);
+int fillScreenAsync(unsigned int color, DisplayDoneCallback done);
+
+int displayDMABusy(void);
+void displayDMAWait(void);
+
+
+#endif /* OLED_OLED_DMA_H_ */
@@ -0,0 +1,182 @@
+/* Off-screen framebuffer for the SSD1351.
+*
+*  Pixels are kept in a 128x128 RGB565 array (32 KB of SRAM) and every
+*  write records the rectangle it touched. Overlapping or adjacent
+*  rectangles are merged as they are added; once FB_MAX_DIRTY are in use
+*  the pair that grows the least when combined is merged to make room.
+*  fbFlush() then sends each dirty rectangle with one address window, a
+*  single CS cycle for the whole flush and no per-pixel commands.
+*
+*  The whole module compiles away unless SSD1351_FRAMEBUFFER is defined.
+*/
+
+#include <string.h>
+
+#include "Adafruit_SSD1351.h"
+#include "oled_framebuffer.h"
+
+#ifdef SSD1351_FRAMEBUFFER
+
+typedef struct {
+  short x0, y0, x1, y1;     // inclusive
+} DirtyRect;
+
+static unsigned short framebuffer[SSD1351WIDTH * SSD1351HEIGHT];
+static DirtyRect dirty[FB_MAX_DIRTY];
+static int dirtyCount = 0;
+
+
+static long rectArea(const DirtyRect *r) {
+  return (long)(r->x1 - r->x0 + 1) * (r->y1 - r->y0 + 1);
+}
+
+static void rectUnion(DirtyRect *a, const DirtyRect *b) {
+  if (b->x0 < a->x0) a->x0 = b->x0;
+  if (b->y0 < a->y0) a->y0 = b->y0;
+  if (b->x1 > a->x1) a->x1 = b->x1;
+  if (b->y1 > a->y1) a->y1 = b->y1;
+}
+
+// True if the rectangles overlap or share an edge
+static int rectTouches(const DirtyRect *a, const DirtyRect *b) {
+  return a->x0 <= b->x1 + 1 && b->x0 <= a->x1 + 1 &&
+         a->y0 <= b->y1 + 1 && b->y0 <= a->y1 + 1;
+}
+
+static void removeDirty(int i) {
+  dirty[i] = dirty[--dirtyCount];
+}
+
+// Merge the pair of rectangles whose union adds the fewest clean pixels
+static void mergeCheapest(void) {
+  int i, j, bi = 0, bj = 1;
+  long best = -1;
+
+  for (i = 0; i < dirtyCount; i++) {
+    for (j = i + 1; j < dirtyCount; j++) {
+      DirtyRect u = dirty[i];
+      long cost;
+
+      rectUnion(&u, &dirty[j]);
+      cost = rectArea(&u) - rectArea(&dirty[i]) - rectArea(&dirty[j]);
+      if (best < 0 || cost < best) {
+        best = cost;
+        bi = i;
+        bj = j;
+      }
+    }
+  }
+
+  rectUnion(&dirty[bi], &dirty[bj]);
+  removeDirty(bj);
+}
+
+unsigned short *fbBuffer(void) {
+  return framebuffer;
+}
+
+void fbMarkDirty(int x, int y, int w, int h) {
+  DirtyRect r;
+  int i;
+
+  if (w <= 0 || h <= 0) return;
+
+  r.x0 = x;
+  r.y0 = y;
+  r.x1 = x + w - 1;
+  r.y1 = y + h - 1;
+
+  // absorb every rectangle the new one touches; the union may now touch
+  // others, so rescan until nothing changes
+  i = 0;
+  while (i < dirtyCount) {
+    if (rectTouches(&r, &dirty[i])) {
+      rectUnion(&r, &dirty[i]);
+      removeDirty(i);
+      i = 0;
+    } else {
+      i++;
+    }
+  }
+
+  if (dirtyCount == FB_MAX_DIRTY) {
+    mergeCheapest();
+  }
+  dirty[dirtyCount++] = r;
+}
+
+void fbDrawPixel(int x, int y, unsigned int color) {
+  if ((x < 0) || (y < 0) || (x >= SSD1351WIDTH) || (y >= SSD1351HEIGHT)) return;
+
+  framebuffer[y * SSD1351WIDTH + x] = color;
+  fbMarkDirty(x, y, 1, 1);
+}
+
+void fbFillRect(int x, int y, int w, int h, unsigned int color) {
+  unsigned short *row;
+  int i, j;
+
+  // clip to the buffer
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (x + w > SSD1351WIDTH) w = SSD1351WIDTH - x;
+  if (y + h > SSD1351HEIGHT) h = SSD1351HEIGHT - y;
+  if (w <= 0 || h <= 0) return;
+
+  row = &framebuffer[y * SSD1351WIDTH + x];
+  for (j = 0; j < h; j++) {
+    for (i = 0; i < w; i++) {
+      row[i] = color;
+    }
+    row += SSD1351WIDTH;
+  }
+  fbMarkDirty(x, y, w, h);
+}
+
+void fbDrawBitmap(int x, int y, const unsigned short *pixels, int w, int h,
+                  int stride) {
+  unsigned short *row = &framebuffer[y * SSD1351WIDTH + x];
+  int j;
+
+  for (j = 0; j < h; j++) {
+    memcpy(row, pixels, w * sizeof(framebuffer[0]));
+    row += SSD1351WIDTH;
+    pixels += stride;
+  }
+  fbMarkDirty(x, y, w, h);
+}
+
+// The rows left behind keep their old contents; the caller clears them
+void fbScroll(int top, int height, int lines) {
+  unsigned short *base = &framebuffer[top * SSD1351WIDTH];
+
+  if (lines > 0) {
+    memmove(base, base + lines * SSD1351WIDTH,
+            (height - lines) * SSD1351WIDTH * sizeof(framebuffer[0]));
+  } else if (lines < 0) {
+    memmove(base - lines * SSD1351WIDTH, base,
+            (height + lines) * SSD1351WIDTH * sizeof(framebuffer[0]));
+  }
+}
+
+void fbFlush(void) {
+  int i, y;
+
+  if (dirtyCount == 0) return;
+
+  startWrite();
+  for (i = 0; i < dirtyCount; i++) {
+    DirtyRect *r = &dirty[i];
+    int w = r->x1 - r->x0 + 1;
+
+    setWindow(r->x0, r->y0, r->x1, r->y1);
+    for (y = r->y0; y <= r->y1; y++) {
+      sendPixels(&framebuffer[y * SSD1351WIDTH + r->x0], w);
+    }
+  }
+  endWrite();
+
+  dirtyCount = 0;
+}
+
+#endif /* SSD1351_FRAMEBUFFER */
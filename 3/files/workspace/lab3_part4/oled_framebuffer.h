@@ -0,0 +1,33 @@
+/*
+ * oled_framebuffer.h
+ *
+ *  Optional off-screen RGB565 framebuffer for the SSD1351. Enabled by
+ *  defining SSD1351_FRAMEBUFFER in Adafruit_SSD1351.h; drawing then goes
+ *  to RAM and only the dirty parts reach the panel on flush().
+ */
+
+#ifndef OLED_OLED_FRAMEBUFFER_H_
+#define OLED_OLED_FRAMEBUFFER_H_
+
+// Number of separate dirty rectangles tracked before they get merged
+#define FB_MAX_DIRTY  8
+
+unsigned short *fbBuffer(void);
+
+void fbDrawPixel(int x, int y, unsigned int color);
+void fbFillRect(int x, int y, int w, int h, unsigned int color);
+void fbMarkDirty(int x, int y, int w, int h);
+
+// Copy a w x h block of pixels, stride pixels per source row; the
+// caller has already clipped it to the buffer
+void fbDrawBitmap(int x, int y, const unsigned short *pixels, int w, int h,
+                  int stride);
+
+// Move rows top..top+height-1 up by lines (down if negative) in RAM only
+void fbScroll(int top, int height, int lines);
+
+// Send every dirty rectangle to the panel and clear the dirty list
+void fbFlush(void);
+
+
+#endif /* OLED_OLED_FRAMEBUFFER_H_ */
@@ -0,0 +1,124 @@
+/* Glyph cache.
+*
+*  Expanded glyphs are packed one after another in a fixed arena of
+*  SSD1351_GLYPH_CACHE_BYTES, in the order they were added. When a new one
+*  does not fit, the least recently used glyphs are evicted and the ones
+*  after them are moved down, so free space is always at the end and a
+*  size 4 glyph can follow a run of size 1 ones.
+*
+*  The whole module compiles away unless SSD1351_GLYPH_CACHE is defined.
+*/
+
+#include <string.h>
+
+#include "Adafruit_GFX.h"
+#include "Adafruit_SSD1351.h"
+#include "oled_glyphcache.h"
+
+#ifdef SSD1351_GLYPH_CACHE
+
+#define ARENA_PIXELS   (SSD1351_GLYPH_CACHE_BYTES / 2)
+#define MAX_ENTRIES    (ARENA_PIXELS / GLYPH_PIXELS(1))
+
+typedef struct {
+  unsigned short color, bg;
+  unsigned char c, size;
+  unsigned short offset;      // first pixel in the arena
+  unsigned long lastUse;
+} CacheEntry;
+
+static unsigned short arena[ARENA_PIXELS];
+static unsigned int arenaUsed = 0;
+
+// sorted by offset
+static CacheEntry entries[MAX_ENTRIES];
+static int entryCount = 0;
+static unsigned long useClock = 0;
+
+unsigned long glyphCacheHits, glyphCacheMisses;
+
+
+// Remove entry i and close the gap it leaves in the arena
+static void evict(int i) {
+  unsigned int start = entries[i].offset;
+  unsigned int n = GLYPH_PIXELS(entries[i].size);
+  int j;
+
+  memmove(&arena[start], &arena[start + n],
+          (arenaUsed - start - n) * sizeof(arena[0]));
+  arenaUsed -= n;
+
+  for (j = i; j < entryCount - 1; j++) {
+    entries[j] = entries[j + 1];
+    entries[j].offset -= n;
+  }
+  entryCount--;
+}
+
+static int leastRecent(void) {
+  int i, lru = 0;
+
+  for (i = 1; i < entryCount; i++) {
+    if (entries[i].lastUse < entries[lru].lastUse) lru = i;
+  }
+  return lru;
+}
+
+// Scale the 5x8 font cell up to 6*size x 8*size pixels, row by row
+static void expand(unsigned short *out, unsigned char c, unsigned int color,
+                   unsigned int bg, unsigned char size) {
+  const unsigned char *glyph = getGlyph(c);
+  int w = 6 * size, h = 8 * size;
+  int i, j;
+
+  for (j = 0; j < h; j++) {
+    for (i = 0; i < w; i++) {
+      int col = i / size;
+      unsigned char line = (col == 5) ? 0 : glyph[col];
+
+      *out++ = ((line >> (j / size)) & 0x1) ? color : bg;
+    }
+  }
+}
+
+const unsigned short *glyphCacheGet(unsigned char c, unsigned int color,
+                                    unsigned int bg, unsigned char size) {
+  unsigned int n = GLYPH_PIXELS(size);
+  CacheEntry *e;
+  int i;
+
+  for (i = 0; i < entryCount; i++) {
+    e = &entries[i];
+    if (e->c == c && e->size == size && e->color == color && e->bg == bg) {
+      e->lastUse = ++useClock;
+      glyphCacheHits++;
+      return &arena[e->offset];
+    }
+  }
+
+  glyphCacheMisses++;
+  if (n > ARENA_PIXELS) return 0;
+
+  while (entryCount == MAX_ENTRIES || arenaUsed + n > ARENA_PIXELS) {
+    evict(leastRecent());
+  }
+
+  e = &entries[entryCount++];
+  e->c = c;
+  e->size = size;
+  e->color = color;
+  e->bg = bg;
+  e->offset = arenaUsed;
+  e->lastUse = ++useClock;
+  arenaUsed += n;
+
+  expand(&arena[e->offset], c, color, bg, size);
+  return &arena[e->offset];
+}
+
+void glyphCacheClear(void) {
+  entryCount = 0;
+  arenaUsed = 0;
+}
+
+#endif /* SSD1351_GLYPH_CACHE */
@@ -0,0 +1,28 @@
+/*
+ * oled_glyphcache.h
+ *
+ *  LRU cache of glyphs already expanded to RGB565, keyed by character,
+ *  colors and text size. Enabled by defining SSD1351_GLYPH_CACHE in
+ *  Adafruit_SSD1351.h; drawChar() then sends cached opaque glyphs as one
+ *  window write without going back to the font bits.
+ */
+
+#ifndef OLED_OLED_GLYPHCACHE_H_
+#define OLED_OLED_GLYPHCACHE_H_
+
+// Pixels of a 6x8 glyph cell at a given text size
+#define GLYPH_PIXELS(size)  (48 * (size) * (size))
+
+// Expanded 6*size x 8*size glyph, from the cache or freshly expanded into
+// it. Returns 0 if the glyph is larger than the whole cache. The pixels
+// stay valid until the next call.
+const unsigned short *glyphCacheGet(unsigned char c, unsigned int color,
+                                    unsigned int bg, unsigned char size);
+
+// Drop every cached glyph
+void glyphCacheClear(void);
+
+extern unsigned long glyphCacheHits, glyphCacheMisses;
+
+
+#endif /* OLED_OLED_GLYPHCACHE_H_ */
@@ -192,46 +192,41 @@ void testlines(unsigned int color) {
 
 //*****************************************************************************
 
+// colors of the eight 16-pixel bands in the test patterns
+static const unsigned short patternColors[8] = {
+  RED, YELLOW, GREEN, CYAN, BLUE, MAGENTA, BLACK, WHITE
+};
+
 void lcdTestPattern(void)
 {
-  unsigned int i,j;
-  goTo(0, 0);
+  unsigned int i;
 
-  for(i=0;i<128;i++)
+  startWrite();
+  setAddrWindow(0, 0, 128, 128);
+  for(i=0;i<8;i++)
   {
-    for(j=0;j<128;j++)
-    {
-      if(i<16){writeData(RED>>8); writeData((unsigned char) RED);}
-      else if(i<32) {writeData(YELLOW>>8);writeData((unsigned char) YELLOW);}
-      else if(i<48){writeData(GREEN>>8);writeData((unsigned char) GREEN);}
-      else if(i<64){writeData(CYAN>>8);writeData((unsigned char) CYAN);}
-      else if(i<80){writeData(BLUE>>8);writeData((unsigned char) BLUE);}
-      else if(i<96){writeData(MAGENTA>>8);writeData((unsigned char) MAGENTA);}
-      else if(i<112){writeData(BLACK>>8);writeData((unsigned char) BLACK);}
-      else {writeData(WHITE>>8); writeData((unsigned char) WHITE);}
-    }
+    sendColor(patternColors[i], 16*128);
   }
+  endWrite();
 }
 /**************************************************************************/
 void lcdTestPattern2(void)
 {
-  unsigned int i,j;
-  goTo(0, 0);
+  unsigned short row[128];
+  unsigned int i;
 
   for(i=0;i<128;i++)
   {
-    for(j=0;j<128;j++)
-    {
-      if(j<16){writeData(RED>>8); writeData((unsigned char) RED);}
-      else if(j<32) {writeData(YELLOW>>8);writeData((unsigned char) YELLOW);}
-      else if(j<48){writeData(GREEN>>8);writeData((unsigned char) GREEN);}
-      else if(j<64){writeData(CYAN>>8);writeData((unsigned char) CYAN);}
-      else if(j<80){writeData(BLUE>>8);writeData((unsigned char) BLUE);}
-      else if(j<96){writeData(MAGENTA>>8);writeData((unsigned char) MAGENTA);}
-      else if(j<112){writeData(BLACK>>8);writeData((unsigned char) BLACK);}
-      else {writeData(WHITE>>8);writeData((unsigned char) WHITE);}
-    }
+    row[i] = patternColors[i/16];
+  }
+
+  startWrite();
+  setAddrWindow(0, 0, 128, 128);
+  for(i=0;i<128;i++)
+  {
+    pushColors(row, 128);
   }
+  endWrite();
 }
 
 /**************************************************************************/
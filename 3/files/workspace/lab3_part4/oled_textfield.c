@@ -0,0 +1,67 @@
+/* Incremental text field.
+*
+*  The field keeps a copy of the characters on screen. Setting new text
+*  compares it cell by cell: a changed character is drawn over its cell,
+*  which drawChar() fills completely when bg != color, and cells that are
+*  no longer used are cleared with a single fillRect(). Typing or deleting
+*  at the end of a message therefore costs one cell, however long the
+*  message is.
+*/
+
+#include "Adafruit_GFX.h"
+#include "Adafruit_SSD1351.h"
+#include "oled_textfield.h"
+
+
+void textFieldInit(TextField *f, int x, int y, int cols, unsigned char size,
+                   unsigned int color, unsigned int bg) {
+  int i;
+
+  if (cols > TEXTFIELD_MAX_COLS) cols = TEXTFIELD_MAX_COLS;
+
+  f->x = x;
+  f->y = y;
+  f->cols = cols;
+  f->size = size;
+  f->color = color;
+  f->bg = bg;
+  for (i = 0; i < cols; i++) {
+    f->shown[i] = 0;
+  }
+}
+
+void textFieldSetText(TextField *f, const char *text) {
+  int cell = 6 * f->size;
+  int oldLength = 0, length = 0;
+  int i;
+  char c;
+
+  for (i = 0; i < f->cols; i++) {
+    if (f->shown[i]) oldLength = i + 1;
+
+    c = *text ? *text++ : 0;
+    if (c) length = i + 1;
+    if (c && c != f->shown[i]) {
+      drawChar(f->x + i*cell, f->y, c, f->color, f->bg, f->size);
+    }
+    f->shown[i] = c;
+  }
+
+  // the cells the text no longer reaches
+  if (length < oldLength) {
+    fillRect(f->x + length*cell, f->y, (oldLength - length)*cell,
+             8 * f->size, f->bg);
+  }
+}
+
+void textFieldSetColor(TextField *f, unsigned int color, unsigned int bg) {
+  int i;
+
+  if (color == f->color && bg == f->bg) return;
+
+  f->color = color;
+  f->bg = bg;
+  for (i = 0; i < f->cols && f->shown[i]; i++) {
+    drawChar(f->x + i*6*f->size, f->y, f->shown[i], color, bg, f->size);
+  }
+}
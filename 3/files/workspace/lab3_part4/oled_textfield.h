@@ -0,0 +1,38 @@
+/*
+ * oled_textfield.h
+ *
+ *  Single-line text field that remembers what it last drew and, when the
+ *  text changes, repaints only the character cells that differ plus any
+ *  tail left over from longer text. Text is drawn opaque, so color and bg
+ *  must differ.
+ */
+
+#ifndef OLED_OLED_TEXTFIELD_H_
+#define OLED_OLED_TEXTFIELD_H_
+
+#include "Adafruit_SSD1351.h"
+
+// Widest field: a full row of size 1 characters
+#define TEXTFIELD_MAX_COLS  (SSD1351WIDTH / 6)
+
+typedef struct {
+  int x, y;                 // top left of the first cell
+  int cols;                 // cells; longer text is cut off
+  unsigned char size;
+  unsigned int color, bg;
+  char shown[TEXTFIELD_MAX_COLS];   // on screen now, 0 for empty cells
+} TextField;
+
+// The field's area must already be bg; nothing is drawn until the first
+// textFieldSetText()
+void textFieldInit(TextField *f, int x, int y, int cols, unsigned char size,
+                   unsigned int color, unsigned int bg);
+
+// Repaint only the cells whose character changed
+void textFieldSetText(TextField *f, const char *text);
+
+// New colors take effect by repainting every shown character
+void textFieldSetColor(TextField *f, unsigned int color, unsigned int bg);
+
+
+#endif /* OLED_OLED_TEXTFIELD_H_ */
@@ -0,0 +1,184 @@
+/* Text layout.
+*
+*  textBreak() is a greedy word wrapper that walks the text once, counting
+*  cells and remembering where the last word began; when the line is full
+*  it ends before that word. Both Outstr() and TextBlock use it.
+*
+*  A TextBlock compares the new layout with the one on screen line by
+*  line. A line that starts at the same byte as before keeps its cells up
+*  to the first changed byte, so typing at the end of a message redraws one
+*  cell. The rest of the line, plus any cells the old line reached beyond
+*  the new one, is sent as a single run of glyphs padded with spaces.
+*/
+
+#include "Adafruit_GFX.h"
+#include "Adafruit_SSD1351.h"
+#include "oled_textlayout.h"
+
+
+//*****************************************************************************
+// Characters
+
+// Bytes in the UTF-8 sequence at s. A malformed or cut-off sequence ends
+// early, so a bad byte costs one cell and never swallows the terminator.
+static int sequenceLength(const char *s) {
+  unsigned char c = *s;
+  int n, i;
+
+  if (c < 0xC0) return 1;
+  n = (c < 0xE0) ? 2 : (c < 0xF0) ? 3 : 4;
+  for (i = 1; i < n; i++) {
+    if (((unsigned char)s[i] & 0xC0) != 0x80) return i;
+  }
+  return n;
+}
+
+unsigned char textGlyph(const char **s) {
+  unsigned char c = **s;
+
+  *s += sequenceLength(*s);
+  return (c < 0x80) ? c : '?';
+}
+
+// Cells taken by the whole characters in the first 'bytes' bytes of s;
+// *at gets the byte where the next character starts
+static int cellsIn(const char *s, int bytes, int *at) {
+  int i = 0, cells = 0, n;
+
+  while (i < bytes) {
+    n = sequenceLength(s + i);
+    if (i + n > bytes) break;
+    i += n;
+    cells++;
+  }
+  *at = i;
+  return cells;
+}
+
+static int trimSpaces(const char *s, int n) {
+  while (n > 0 && s[n - 1] == ' ') n--;
+  return n;
+}
+
+int textBreak(const char *s, int used, int cols, int *next) {
+  int i = 0, cells = used, n;
+  int word = (used > 0) ? 0 : -1;   // start of the last word, -1 for none
+
+  for (;;) {
+    if (!s[i] || s[i] == '\n') {
+      *next = s[i] ? i + 1 : i;
+      return i;
+    }
+
+    if (s[i] == ' ') {
+      if (cells < cols) {
+        cells++;
+        i++;
+        continue;
+      }
+
+      // full at a space: end the line here and drop the spaces
+      n = i;
+      while (s[i] == ' ') i++;
+      if (s[i] == '\n') i++;
+      *next = i;
+      return trimSpaces(s, n);
+    }
+
+    if (i > 0 && s[i - 1] == ' ') word = i;
+    if (cells >= cols) {
+      // full inside a word: move the word down, or split it if it is the
+      // only one on the line
+      if (word < 0) word = i;
+      *next = word;
+      return trimSpaces(s, word);
+    }
+
+    cells++;
+    i += sequenceLength(s + i);
+  }
+}
+
+//*****************************************************************************
+// Text blocks
+
+void textBlockInit(TextBlock *b, int x, int y, int cols, int rows,
+                   unsigned char size, unsigned int color, unsigned int bg) {
+  int k;
+
+  if (cols > TEXTBLOCK_MAX_COLS) cols = TEXTBLOCK_MAX_COLS;
+  if (cols < 1) cols = 1;
+  if (rows > TEXTBLOCK_MAX_LINES) rows = TEXTBLOCK_MAX_LINES;
+
+  b->x = x;
+  b->y = y;
+  b->cols = cols;
+  b->rows = rows;
+  b->size = size;
+  b->color = color;
+  b->bg = bg;
+  b->repaint = 0;
+  b->lines = 0;
+  for (k = 0; k < rows; k++) {
+    b->start[k] = 0;
+    b->length[k] = 0;
+    b->cells[k] = 0;
+  }
+}
+
+void textBlockSetText(TextBlock *b, const char *text, int from) {
+  unsigned char glyphs[TEXTBLOCK_MAX_COLS];
+  int k, i, pos = 0, n, next, first, limit, at, col, cells, end;
+  const char *s;
+
+  if (b->repaint) from = 0;
+  b->repaint = 0;
+  b->lines = 0;
+
+#ifndef SSD1351_FRAMEBUFFER
+  startWrite();
+#endif
+  for (k = 0; k < b->rows; k++) {
+    n = 0;
+    next = 0;
+    if (text[pos]) {
+      n = textBreak(text + pos, 0, b->cols, &next);
+      b->lines = k + 1;
+    }
+
+    // where this line stops matching what is on screen
+    first = pos;
+    if (pos == b->start[k]) {
+      limit = pos + ((n < b->length[k]) ? n : b->length[k]);
+      first = (from < pos) ? pos : (from > limit) ? limit : from;
+    }
+    col = cellsIn(text + pos, first - pos, &at);
+    cells = cellsIn(text + pos, n, &i);
+    end = (cells > b->cells[k]) ? cells : b->cells[k];
+
+    if (col < end) {
+      s = text + pos + at;
+      for (i = col; i < end; i++) {
+        glyphs[i - col] = (i < cells) ? textGlyph(&s) : ' ';
+      }
+      drawGlyphRun(b->x + col*6*b->size, b->y + k*8*b->size, glyphs,
+                   end - col, b->color, b->bg, b->size);
+    }
+
+    b->start[k] = pos;
+    b->length[k] = n;
+    b->cells[k] = cells;
+    pos += next;
+  }
+#ifndef SSD1351_FRAMEBUFFER
+  endWrite();
+#endif
+}
+
+void textBlockSetColor(TextBlock *b, unsigned int color, unsigned int bg) {
+  if (color == b->color && bg == b->bg) return;
+
+  b->color = color;
+  b->bg = bg;
+  b->repaint = 1;
+}
@@ -0,0 +1,55 @@
+/*
+ * oled_textlayout.h
+ *
+ *  Word-wrapping text layout. Text is UTF-8: every character takes one
+ *  cell, and characters outside ASCII are shown as '?' since the font only
+ *  has ASCII glyphs. A TextBlock keeps the line breaks of the text it drew
+ *  last, so new text only costs the lines, and the cells within them, that
+ *  changed. Each changed stretch goes out as one drawGlyphRun().
+ */
+
+#ifndef OLED_OLED_TEXTLAYOUT_H_
+#define OLED_OLED_TEXTLAYOUT_H_
+
+#include "Adafruit_SSD1351.h"
+
+#define TEXTBLOCK_MAX_COLS   (SSD1351WIDTH / 6)
+#define TEXTBLOCK_MAX_LINES  8
+
+// Glyph for the character at *s, which is moved past it
+unsigned char textGlyph(const char **s);
+
+// Lays out one line of at most cols cells, of which the first 'used' are
+// already taken, breaking after the last whole word that fits. Returns the
+// bytes to draw and sets *next to where the following line starts. A word
+// wider than a whole line is split; with used > 0 it moves down instead,
+// and the result is an empty line with *next = 0.
+int textBreak(const char *s, int used, int cols, int *next);
+
+typedef struct {
+  int x, y;                 // top left of the first cell
+  int cols, rows;           // cells per line, lines; more text is cut off
+  unsigned char size;
+  unsigned int color, bg;
+  unsigned char repaint;    // colors changed since the last draw
+  int lines;                // lines the text took last time
+  // layout of what is on screen now
+  unsigned short start[TEXTBLOCK_MAX_LINES];   // first byte of each line
+  unsigned short length[TEXTBLOCK_MAX_LINES];  // bytes drawn on each line
+  unsigned char cells[TEXTBLOCK_MAX_LINES];    // cells drawn on each line
+} TextBlock;
+
+// The block's area must already be bg; nothing is drawn until the first
+// textBlockSetText(). Text is drawn opaque, so color and bg must differ.
+void textBlockInit(TextBlock *b, int x, int y, int cols, int rows,
+                   unsigned char size, unsigned int color, unsigned int bg);
+
+// Lays text out and redraws what changed. Bytes before 'from' must be the
+// same as in the text of the previous call; pass 0 when that is unknown.
+void textBlockSetText(TextBlock *b, const char *text, int from);
+
+// Takes effect on the next textBlockSetText(), which repaints every line
+void textBlockSetColor(TextBlock *b, unsigned int color, unsigned int bg);
+
+
+#endif /* OLED_OLED_TEXTLAYOUT_H_ */
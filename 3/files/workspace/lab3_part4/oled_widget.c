@@ -0,0 +1,212 @@
+/* Retained widgets.
+*
+*  Each widget remembers its bounds, colors and the text it should show,
+*  and a dirty state that says how much of it is stale. Nothing is drawn
+*  by the setters. screenRender() walks the widgets in z-order, which is
+*  the order they were added, and for each dirty one either lets the
+*  TextField or TextBlock redraw the changed cells (WIDGET_CHANGED) or
+*  fills the bounds with bg and draws it again (WIDGET_INVALID). Whatever
+*  a repaint touches may cover widgets stacked above it, so those are
+*  invalidated before the walk reaches them.
+*/
+
+#include "Adafruit_GFX.h"
+#include "Adafruit_SSD1351.h"
+#include "oled_widget.h"
+
+
+//*****************************************************************************
+// Screen
+
+void screenInit(Screen *s) {
+  s->first = 0;
+  s->last = 0;
+}
+
+void screenAdd(Screen *s, Widget *w) {
+  w->next = 0;
+  w->dirty = WIDGET_INVALID;
+  if (s->last) {
+    s->last->next = w;
+  } else {
+    s->first = w;
+  }
+  s->last = w;
+}
+
+void screenInvalidate(Screen *s) {
+  Widget *w;
+
+  for (w = s->first; w; w = w->next) {
+    w->dirty = WIDGET_INVALID;
+  }
+}
+
+static int overlaps(const Widget *a, const Widget *b) {
+  return a->x < b->x + b->w && b->x < a->x + a->w &&
+         a->y < b->y + b->h && b->y < a->y + a->h;
+}
+
+static void widgetPaint(Widget *w) {
+  TextBlock *b = &w->block;
+
+  if (w->dirty == WIDGET_INVALID) {
+    if (w->kind == WIDGET_DIVIDER) {
+      drawFastHLine(w->x, w->y, w->w, w->color);
+      return;
+    }
+
+    // start the field over on a blank area
+    fillRect(w->x, w->y, w->w, w->h, w->bg);
+    if (w->kind == WIDGET_PARAGRAPH) {
+      textBlockInit(b, b->x, b->y, b->cols, b->rows, b->size, w->color, w->bg);
+    } else {
+      textFieldInit(&w->field, w->field.x, w->field.y, w->field.cols,
+                    w->field.size, w->color, w->bg);
+    }
+  }
+
+  if (w->kind == WIDGET_PARAGRAPH) {
+    textBlockSetColor(b, w->color, w->bg);
+    textBlockSetText(b, w->text, w->from);
+  } else {
+    textFieldSetColor(&w->field, w->color, w->bg);
+    textFieldSetText(&w->field, w->text);
+  }
+  w->from = WIDGET_MAX_TEXT;
+}
+
+void screenRender(Screen *s) {
+  Widget *w, *above;
+
+#ifndef SSD1351_FRAMEBUFFER
+  startWrite();
+#endif
+  for (w = s->first; w; w = w->next) {
+    if (w->dirty == WIDGET_CLEAN) continue;
+
+    widgetPaint(w);
+    w->dirty = WIDGET_CLEAN;
+
+    for (above = w->next; above; above = above->next) {
+      if (overlaps(w, above)) above->dirty = WIDGET_INVALID;
+    }
+  }
+#ifndef SSD1351_FRAMEBUFFER
+  endWrite();
+#endif
+}
+
+//*****************************************************************************
+// Widgets
+
+static void widgetFields(Widget *w, WidgetKind kind, int x, int y, int cols,
+                         unsigned char size, unsigned int color,
+                         unsigned int bg) {
+  textFieldInit(&w->field, x, y, cols, size, color, bg);
+  w->kind = kind;
+  w->x = x;
+  w->y = y;
+  w->w = w->field.cols * 6 * size;
+  w->h = 8 * size;
+  w->color = color;
+  w->bg = bg;
+  w->dirty = WIDGET_INVALID;
+  w->text[0] = 0;
+  w->from = 0;
+  w->next = 0;
+}
+
+void widgetLabel(Widget *w, int x, int y, const char *text, unsigned char size,
+                 unsigned int color, unsigned int bg) {
+  int cols = 0;
+
+  while (text[cols]) cols++;
+  widgetFields(w, WIDGET_LABEL, x, y, cols, size, color, bg);
+  widgetSetText(w, text);
+}
+
+void widgetText(Widget *w, int x, int y, int cols, unsigned char size,
+                unsigned int color, unsigned int bg) {
+  widgetFields(w, WIDGET_TEXT, x, y, cols, size, color, bg);
+}
+
+void widgetParagraph(Widget *w, int x, int y, int cols, int rows,
+                     unsigned char size, unsigned int color, unsigned int bg) {
+  textBlockInit(&w->block, x, y, cols, rows, size, color, bg);
+  w->kind = WIDGET_PARAGRAPH;
+  w->x = x;
+  w->y = y;
+  w->w = w->block.cols * 6 * size;
+  w->h = w->block.rows * 8 * size;
+  w->color = color;
+  w->bg = bg;
+  w->dirty = WIDGET_INVALID;
+  w->text[0] = 0;
+  w->from = 0;
+  w->next = 0;
+}
+
+void widgetDivider(Widget *w, int x, int y, int length, unsigned int color) {
+  w->kind = WIDGET_DIVIDER;
+  w->x = x;
+  w->y = y;
+  w->w = length;
+  w->h = 1;
+  w->color = color;
+  w->bg = color;
+  w->dirty = WIDGET_INVALID;
+  w->text[0] = 0;
+  w->from = 0;
+  w->next = 0;
+}
+
+// The text sits one pixel in from the top left of the bar
+void widgetStatusBar(Widget *w, int y, unsigned char size,
+                     unsigned int color, unsigned int bg) {
+  widgetFields(w, WIDGET_STATUS, 1, y + 1, (SSD1351WIDTH - 2) / (6 * size),
+               size, color, bg);
+  w->x = 0;
+  w->y = y;
+  w->w = SSD1351WIDTH;
+  w->h = 8 * size + 2;
+}
+
+void widgetSetText(Widget *w, const char *text) {
+  int fits = (w->kind == WIDGET_PARAGRAPH) ? WIDGET_MAX_TEXT : w->field.cols;
+  int i;
+
+  if (w->kind == WIDGET_DIVIDER) return;
+
+  // same text, up to what fits
+  i = 0;
+  while (i < fits && text[i] && text[i] == w->text[i]) i++;
+  if (i == fits || text[i] == w->text[i]) return;
+
+  if (i < w->from) w->from = i;
+  for (; i < fits && text[i]; i++) {
+    w->text[i] = text[i];
+  }
+  w->text[i] = 0;
+
+  if (w->dirty == WIDGET_CLEAN) w->dirty = WIDGET_CHANGED;
+}
+
+void widgetSetColor(Widget *w, unsigned int color, unsigned int bg) {
+  if (w->kind == WIDGET_DIVIDER) bg = color;
+  if (color == w->color && bg == w->bg) return;
+
+  // a new bg or a divider has to be filled again; the field can recolor its
+  // characters in place
+  if (bg != w->bg || w->kind == WIDGET_DIVIDER) {
+    w->dirty = WIDGET_INVALID;
+  } else if (w->dirty == WIDGET_CLEAN) {
+    w->dirty = WIDGET_CHANGED;
+  }
+  w->color = color;
+  w->bg = bg;
+}
+
+void widgetInvalidate(Widget *w) {
+  w->dirty = WIDGET_INVALID;
+}
@@ -0,0 +1,79 @@
+/*
+ * oled_widget.h
+ *
+ *  Retained widgets for the chat screen. A Screen keeps its widgets in
+ *  z-order, each with its bounds and a dirty state. Setters only record
+ *  what changed; screenRender() repaints the dirty widgets bottom to top.
+ *  Text widgets draw through a TextField, and paragraphs through a
+ *  TextBlock, so a new string still costs only the cells that differ.
+ */
+
+#ifndef OLED_OLED_WIDGET_H_
+#define OLED_OLED_WIDGET_H_
+
+#include "oled_textfield.h"
+#include "oled_textlayout.h"
+
+typedef enum {
+  WIDGET_LABEL,           // text set once when the widget is made
+  WIDGET_TEXT,            // text that changes
+  WIDGET_PARAGRAPH,       // text that changes, word wrapped over lines
+  WIDGET_DIVIDER,         // horizontal rule
+  WIDGET_STATUS           // full-width bar with text on it
+} WidgetKind;
+
+// Dirty states, in increasing amount of work for screenRender()
+#define WIDGET_CLEAN      0
+#define WIDGET_CHANGED    1   // new text or text color: redraw what differs
+#define WIDGET_INVALID    2   // repaint everything inside the bounds
+
+// Longest text a widget keeps
+#define WIDGET_MAX_TEXT   63
+
+typedef struct Widget {
+  WidgetKind kind;
+  int x, y, w, h;                     // bounds on screen
+  unsigned int color, bg;
+  unsigned char dirty;
+  TextField field;                    // labels, text and status bars
+  TextBlock block;                    // paragraphs
+  char text[WIDGET_MAX_TEXT + 1];     // text to show on the next render
+  int from;                           // first byte changed since then
+  struct Widget *next;                // next widget up in z-order
+} Widget;
+
+typedef struct {
+  Widget *first, *last;
+} Screen;
+
+void screenInit(Screen *s);
+
+// Stacks the widget on top of those already added; it is drawn in full on
+// the next render
+void screenAdd(Screen *s, Widget *w);
+
+// Marks every widget for a full repaint, e.g. after the screen was cleared
+void screenInvalidate(Screen *s);
+
+// Repaints the dirty widgets bottom to top. A repainted widget invalidates
+// the widgets above it that it overlaps.
+void screenRender(Screen *s);
+
+// Text widgets are opaque, so color and bg must differ
+void widgetLabel(Widget *w, int x, int y, const char *text, unsigned char size,
+                 unsigned int color, unsigned int bg);
+void widgetText(Widget *w, int x, int y, int cols, unsigned char size,
+                unsigned int color, unsigned int bg);
+void widgetParagraph(Widget *w, int x, int y, int cols, int rows,
+                     unsigned char size, unsigned int color, unsigned int bg);
+void widgetDivider(Widget *w, int x, int y, int length, unsigned int color);
+void widgetStatusBar(Widget *w, int y, unsigned char size,
+                     unsigned int color, unsigned int bg);
+
+// Text longer than the widget is cut off
+void widgetSetText(Widget *w, const char *text);
+void widgetSetColor(Widget *w, unsigned int color, unsigned int bg);
+void widgetInvalidate(Widget *w);
+
+
+#endif /* OLED_OLED_WIDGET_H_ */